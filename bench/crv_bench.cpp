@@ -0,0 +1,196 @@
+#include "crv.h"
+
+#include <chrono>
+#include <cstdio>
+
+// Compare solver backends and time encodings on the programs of
+// test/crv_functional_test.cpp, run with "make bench"
+
+typedef std::function<smt::Solver*(smt::Logic)> SolverFactory;
+typedef std::function<unsigned(crv::Encoder&)> Program;
+
+void fib_t0(
+  const unsigned N,
+  crv::External<int>& i,
+  crv::External<int>& j)
+{
+  for (unsigned k = 0; k < N; k++)
+    i = i + j;
+}
+
+void fib_t1(
+  const unsigned N,
+  crv::External<int>& i,
+  crv::External<int>& j)
+{
+  for (unsigned k = 0; k < N; k++)
+    j = j + i;
+}
+
+// Returns one if the error is satisfiable
+template<bool is_sat>
+unsigned fib(crv::Encoder& encoder)
+{
+  constexpr unsigned N = 6;
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  if (is_sat)
+    crv::tracer().add_error(377 <= i || 377 <= j);
+  else
+    crv::tracer().add_error(377 < i || 377 < j);
+
+  t0.join();
+  t1.join();
+
+  return smt::sat == encoder.check(crv::tracer());
+}
+
+void stateful_t0(
+  crv::Mutex& mutex,
+  crv::External<int>& i,
+  crv::External<int>& j)
+{
+  mutex.lock();
+  i = i + 1;
+  mutex.unlock();
+
+  mutex.lock();
+  j = j + 1;
+  mutex.unlock();
+}
+
+void stateful_t1(
+  crv::Mutex& mutex,
+  crv::External<int>& i,
+  crv::External<int>& j)
+{
+  mutex.lock();
+  i = i + 5;
+  mutex.unlock();
+
+  mutex.lock();
+  j = j - 6;
+  mutex.unlock();
+}
+
+// Returns the number of paths with a satisfiable error
+template<bool is_sat>
+unsigned stateful(crv::Encoder& encoder)
+{
+  crv::Mutex mutex;
+  crv::External<int> i(10), j(10);
+
+  unsigned sat_cnt = 0;
+  do
+  {
+    crv::Thread t0(stateful_t0, mutex, i, j);
+    crv::Thread t1(stateful_t1, mutex, i, j);
+
+    t0.join();
+    t1.join();
+
+    if (is_sat)
+      crv::tracer().add_error(i == 16 && j == 5);
+    else
+      crv::tracer().add_error(i != 16 || j != 5);
+
+    if (!crv::tracer().errors().empty() &&
+        smt::sat == encoder.check(crv::tracer()))
+      sat_cnt++;
+  }
+  while (crv::tracer().flip());
+  return sat_cnt;
+}
+
+void incremental_t0(crv::External<int>& x, crv::External<int>& y)
+{
+  if (crv::tracer().append_guard(x < 3))
+    y = y + 1;
+  else
+    y = y - 1;
+
+  if (crv::tracer().append_guard(y == x))
+    x = 5;
+}
+
+void incremental_t1(crv::External<int>& x, crv::External<int>& y)
+{
+  x = x + 1;
+  if (crv::tracer().append_guard(0 < y))
+    y = x;
+}
+
+// Returns the number of paths with a satisfiable error
+unsigned incremental(crv::Encoder& encoder)
+{
+  unsigned sat_cnt = 0;
+  do
+  {
+    crv::External<int> x(0), y(2);
+
+    crv::Thread t0(incremental_t0, x, y);
+    crv::Thread t1(incremental_t1, x, y);
+
+    t0.join();
+    t1.join();
+
+    crv::tracer().add_error(x == y);
+
+    if (smt::sat == encoder.check(crv::tracer()))
+      sat_cnt++;
+  }
+  while (crv::tracer().flip());
+  return sat_cnt;
+}
+
+int main()
+{
+  const std::vector<std::pair<const char*, SolverFactory>> backends =
+  {
+    { "CVC4", [](smt::Logic logic) { return new smt::CVC4Solver(logic); } },
+    { "Z3", [](smt::Logic logic) { return new smt::Z3Solver(logic); } },
+    { "MathSAT5", [](smt::Logic logic) { return new smt::MsatSolver(logic); } },
+  };
+
+  const std::vector<std::pair<const char*, crv::TimeEncoding>> time_encodings =
+  {
+    { "Int", crv::INT_TIME },
+    { "BV", crv::BV_TIME },
+  };
+
+  const std::vector<std::pair<const char*, Program>> programs =
+  {
+    { "UnsatFib6", fib<false> },
+    { "SatFib6", fib<true> },
+    { "UnsatStateful", stateful<false> },
+    { "SatStateful", stateful<true> },
+    { "Incremental", incremental },
+  };
+
+  std::printf("%-16s%-12s%-8s%8s%12s\n",
+    "program", "backend", "time", "sat", "ms");
+
+  for (const auto& program : programs)
+    for (const auto& backend : backends)
+      for (const auto& time_encoding : time_encodings)
+      {
+        std::unique_ptr<smt::Solver> solver(
+          backend.second(crv::Encoder::logic(time_encoding.second)));
+        crv::Encoder encoder(*solver, time_encoding.second);
+
+        crv::tracer().reset();
+        const auto start = std::chrono::steady_clock::now();
+        const unsigned sat_cnt = program.second(encoder);
+        const auto end = std::chrono::steady_clock::now();
+
+        std::printf("%-16s%-12s%-8s%8u%12lld\n",
+          program.first, backend.first, time_encoding.first, sat_cnt,
+          static_cast<long long>(std::chrono::duration_cast<
+            std::chrono::milliseconds>(end - start).count()));
+      }
+
+  return 0;
+}
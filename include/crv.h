@@ -8,17 +8,46 @@
 #include <smt>
 #include <set>
 #include <unordered_map>
+#include <vector>
+#include <memory>
 #include <list>
 #include <stack>
+#include <algorithm>
 #include <string>
 #include <limits>
+#include <stdexcept>
 #include <cassert>
 #include <type_traits>
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <random>
 
 #ifdef __CRV_DEBUG__
 #include <iostream>
 #endif
 
+// Constant folding checks for overflow with the GCC and Clang builtins
+// if available, or else it folds only what fits into intmax_t
+#ifndef CRV_OVERFLOW_BUILTINS
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_add_overflow) && \
+    __has_builtin(__builtin_sub_overflow) && \
+    __has_builtin(__builtin_mul_overflow)
+#define CRV_OVERFLOW_BUILTINS 1
+#endif
+#elif defined(__GNUC__) && 5 <= __GNUC__
+#define CRV_OVERFLOW_BUILTINS 1
+#endif
+#endif
+
+#ifndef CRV_OVERFLOW_BUILTINS
+#define CRV_OVERFLOW_BUILTINS 0
+#endif
+
 namespace crv
 {
 
@@ -43,6 +72,9 @@ typedef unsigned int EventIdentifier;
 /// Positive if and only if thread is joinable
 typedef unsigned ThreadIdentifier;
 
+/// Index of a guard in its EventList, see EventList::guard()
+typedef unsigned int GuardIdentifier;
+
 class Event
 {
 public:
@@ -50,7 +82,7 @@ public:
   const EventIdentifier event_id;
   const ThreadIdentifier thread_id;
   const Address address;
-  const smt::Bool guard;
+  const GuardIdentifier guard_id;
   const smt::UnsafeTerm term;
   const smt::UnsafeTerm offset_term;
 
@@ -59,7 +91,7 @@ public:
     event_id(other.event_id),
     thread_id(other.thread_id),
     address(other.address),
-    guard(std::move(other.guard)),
+    guard_id(other.guard_id),
     term(std::move(other.term)),
     offset_term(std::move(other.offset_term)) {}
 
@@ -68,18 +100,17 @@ public:
     const EventIdentifier event_id_arg,
     const ThreadIdentifier thread_id_arg,
     const Address address_arg,
-    const smt::Bool guard_arg,
+    const GuardIdentifier guard_id_arg,
     const smt::UnsafeTerm& term_arg,
     const smt::UnsafeTerm& offset_term_arg)
   : kind(kind_arg),
     event_id(event_id_arg),
     thread_id(thread_id_arg),
     address(address_arg),
-    guard(guard_arg),
+    guard_id(guard_id_arg),
     term(term_arg),
     offset_term(offset_term_arg)
   {
-    assert(!guard.is_null());
     assert(is_sync() || !term.is_null());
     assert(is_thread_begin() || is_thread_end() || 0 < address);
   }
@@ -95,56 +126,163 @@ public:
   bool is_sync() const { return is_thread_begin() || is_thread_end(); }
 };
 
-typedef std::list<Event> EventList;
-typedef EventList::const_iterator EventIter;
+/// Index of an event in its EventList
 
-}
+/// Unlike the EventIdentifier of an event, which is shared by events
+/// that synchronize (e.g. THREAD_BEGIN_EVENT), handles are unique.
+typedef unsigned int EventHandle;
 
-namespace std
+/// Append-only sequence of events stored in fixed-size chunks
+
+/// Like a std::vector, events are laid out contiguously (except at
+/// chunk boundaries) and accessed in constant time by their handle;
+/// unlike a std::vector, events never move once they are appended.
+///
+/// Guards are interned in a table so that all events of the same
+/// guard region share one entry, see Event::guard_id.
+class EventList
 {
-  template<>
-  class hash<crv::EventIter>
+private:
+  static constexpr size_t s_chunk_size = 1024;
+
+  typedef std::aligned_storage<sizeof(Event),
+    alignof(Event)>::type EventStorage;
+  typedef std::unique_ptr<EventStorage[]> Chunk;
+
+  std::vector<Chunk> m_chunks;
+  size_t m_size;
+
+  // indexed by guard identifier
+  std::vector<smt::Bool> m_guards;
+
+  EventStorage& storage(const EventHandle e_handle) const
   {
+    return m_chunks[e_handle / s_chunk_size][e_handle % s_chunk_size];
+  }
+
+public:
+  class const_iterator
+  {
+  private:
+    const EventList* m_events;
+    EventHandle m_e_handle;
+
   public:
-    size_t operator()(const crv::EventIter& e_iter) const
+    const_iterator(const EventList* events, EventHandle e_handle)
+    : m_events(events),
+      m_e_handle(e_handle) {}
+
+    EventHandle handle() const { return m_e_handle; }
+
+    const Event& operator*() const { return (*m_events)[m_e_handle]; }
+    const Event* operator->() const { return &(*m_events)[m_e_handle]; }
+
+    const_iterator& operator++() { ++m_e_handle; return *this; }
+    const_iterator& operator--() { --m_e_handle; return *this; }
+    const_iterator operator++(int) { return {m_events, m_e_handle++}; }
+    const_iterator operator--(int) { return {m_events, m_e_handle--}; }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return m_e_handle == other.m_e_handle;
+    }
+
+    bool operator!=(const const_iterator& other) const
     {
-      return e_iter->event_id;
+      return m_e_handle != other.m_e_handle;
     }
   };
 
-  template<>
-  class hash<std::pair<crv::EventIter, crv::EventIter>>
+  EventList()
+  : m_chunks(),
+    m_size(0),
+    m_guards() {}
+
+  EventList(const EventList&) = delete;
+  EventList& operator=(const EventList&) = delete;
+
+  ~EventList()
   {
-  public:
-    size_t operator()(const std::pair<crv::EventIter, crv::EventIter>& p) const
-    {
-      constexpr crv::EventIdentifier max_event_id =
-        numeric_limits<crv::EventIdentifier>::max();
+    clear();
+  }
 
-      static_assert(max_event_id * 2 < numeric_limits<size_t>::max(),
-        "size_t must be at least twice as large as crv::EventIdentifier");
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
 
-      return p.first->event_id * max_event_id + p.second->event_id;
-    }
-  };
-}
+  const Event& operator[](const EventHandle e_handle) const
+  {
+    assert(e_handle < m_size);
+    return reinterpret_cast<const Event&>(storage(e_handle));
+  }
 
-namespace crv
-{
+  const Event& back() const
+  {
+    assert(!empty());
+    return (*this)[m_size - 1];
+  }
+
+  size_t guards_size() const { return m_guards.size(); }
 
-typedef std::vector<EventIter> EventIterList;
+  const smt::Bool& guard(const GuardIdentifier guard_id) const
+  {
+    assert(guard_id < m_guards.size());
+    return m_guards[guard_id];
+  }
+
+  /// Returns the identifier of the new guard
+  GuardIdentifier push_guard(const smt::Bool& guard)
+  {
+    assert(!guard.is_null());
+    assert(m_guards.size() < std::numeric_limits<GuardIdentifier>::max());
+
+    m_guards.push_back(guard);
+    return m_guards.size() - 1;
+  }
+
+  /// Returns the handle of the new event
+  EventHandle push_back(Event&& e)
+  {
+    assert(m_size < std::numeric_limits<EventHandle>::max());
+    assert(e.guard_id < m_guards.size());
+
+    const EventHandle e_handle(m_size);
+    if (m_chunks.size() * s_chunk_size == m_size)
+      m_chunks.emplace_back(new EventStorage[s_chunk_size]);
+
+    new (&storage(e_handle)) Event(std::move(e));
+    m_size++;
+    return e_handle;
+  }
+
+  /// Destroys all events and guards but keeps the chunks for reuse
+  void clear()
+  {
+    for (size_t i = 0; i < m_size; i++)
+      reinterpret_cast<Event&>(storage(i)).~Event();
+
+    m_size = 0;
+    m_guards.clear();
+  }
+
+  const_iterator begin() const { return cbegin(); }
+  const_iterator end() const { return cend(); }
+  const_iterator cbegin() const { return {this, 0}; }
+  const_iterator cend() const { return {this, static_cast<EventHandle>(m_size)}; }
+};
+
+typedef std::vector<EventHandle> EventHandles;
 
 class EventKinds
 {
 private:
-  EventIterList m_reads;
-  EventIterList m_writes;
-  EventIterList m_pops;
-  EventIterList m_pushes;
-  EventIterList m_loads;
-  EventIterList m_stores;
-  EventIterList m_recvs;
-  EventIterList m_sends;
+  EventHandles m_reads;
+  EventHandles m_writes;
+  EventHandles m_pops;
+  EventHandles m_pushes;
+  EventHandles m_loads;
+  EventHandles m_stores;
+  EventHandles m_recvs;
+  EventHandles m_sends;
 
 public:
   EventKinds()
@@ -157,69 +295,189 @@ public:
 
   // See member function template specializations
   template<EventKind kind>
-  void push_back(const EventIter e_iter) { /* skip */ }
-
-  const EventIterList& reads()  const { return m_reads;  }
-  const EventIterList& writes() const { return m_writes; }
-  const EventIterList& pops()   const { return m_pops;   }
-  const EventIterList& pushes() const { return m_pushes; }
-  const EventIterList& loads()  const { return m_loads;  }
-  const EventIterList& stores() const { return m_stores; }
-  const EventIterList& recvs()  const { return m_recvs;  }
-  const EventIterList& sends()  const { return m_sends;  }
+  void push_back(const EventHandle e_handle) { /* skip */ }
+
+  const EventHandles& reads()  const { return m_reads;  }
+  const EventHandles& writes() const { return m_writes; }
+  const EventHandles& pops()   const { return m_pops;   }
+  const EventHandles& pushes() const { return m_pushes; }
+  const EventHandles& loads()  const { return m_loads;  }
+  const EventHandles& stores() const { return m_stores; }
+  const EventHandles& recvs()  const { return m_recvs;  }
+  const EventHandles& sends()  const { return m_sends;  }
+
+  void clear()
+  {
+    m_reads.clear();
+    m_writes.clear();
+    m_pops.clear();
+    m_pushes.clear();
+    m_loads.clear();
+    m_stores.clear();
+    m_recvs.clear();
+    m_sends.clear();
+  }
 };
 
 template<> inline
-void EventKinds::push_back<READ_EVENT>(const EventIter e_iter)
+void EventKinds::push_back<READ_EVENT>(const EventHandle e_handle)
 {
-  m_reads.push_back(e_iter);
+  m_reads.push_back(e_handle);
 }
 
 template<> inline
-void EventKinds::push_back<WRITE_EVENT>(const EventIter e_iter)
+void EventKinds::push_back<WRITE_EVENT>(const EventHandle e_handle)
 {
-  m_writes.push_back(e_iter);
+  m_writes.push_back(e_handle);
 }
 
 template<> inline
-void EventKinds::push_back<POP_EVENT>(const EventIter e_iter)
+void EventKinds::push_back<POP_EVENT>(const EventHandle e_handle)
 {
-  m_pops.push_back(e_iter);
+  m_pops.push_back(e_handle);
 }
 
 template<> inline
-void EventKinds::push_back<PUSH_EVENT>(const EventIter e_iter)
+void EventKinds::push_back<PUSH_EVENT>(const EventHandle e_handle)
 {
-  m_pushes.push_back(e_iter);
+  m_pushes.push_back(e_handle);
 }
 
 template<> inline
-void EventKinds::push_back<LOAD_EVENT>(const EventIter e_iter)
+void EventKinds::push_back<LOAD_EVENT>(const EventHandle e_handle)
 {
-  m_loads.push_back(e_iter);
+  m_loads.push_back(e_handle);
 }
 
 template<> inline
-void EventKinds::push_back<STORE_EVENT>(const EventIter e_iter)
+void EventKinds::push_back<STORE_EVENT>(const EventHandle e_handle)
 {
-  m_stores.push_back(e_iter);
+  m_stores.push_back(e_handle);
 }
 
 template<> inline
-void EventKinds::push_back<RECV_EVENT>(const EventIter e_iter)
+void EventKinds::push_back<RECV_EVENT>(const EventHandle e_handle)
 {
-  m_recvs.push_back(e_iter);
+  m_recvs.push_back(e_handle);
 }
 
 template<> inline
-void EventKinds::push_back<SEND_EVENT>(const EventIter e_iter)
+void EventKinds::push_back<SEND_EVENT>(const EventHandle e_handle)
 {
-  m_sends.push_back(e_iter);
+  m_sends.push_back(e_handle);
 }
 
-typedef std::unordered_map<Address, EventKinds> PerAddressMap;
-typedef std::unordered_map<ThreadIdentifier, EventIterList> PerThreadMap;
-typedef std::unordered_map<EventIter, EventIterList> PerEventMap;
+/// Map whose keys are small integers such as Address or ThreadIdentifier
+
+/// Values are stored in a vector indexed directly by key, so lookups
+/// do not hash. As with std::unordered_map, operator[] inserts a value
+/// if there is none. Iteration follows the order of insertion.
+template<typename Key, typename T>
+class DenseMap
+{
+public:
+  typedef std::pair<Key, T> value_type;
+
+private:
+  std::vector<value_type> m_values;
+  std::vector<bool> m_present;
+  std::vector<Key> m_keys;
+
+public:
+  class const_iterator
+  {
+  private:
+    const DenseMap* m_map;
+    typename std::vector<Key>::const_iterator m_keys_iter;
+
+  public:
+    const_iterator(
+      const DenseMap* map,
+      typename std::vector<Key>::const_iterator keys_iter)
+    : m_map(map),
+      m_keys_iter(keys_iter) {}
+
+    const value_type& operator*() const
+    {
+      return m_map->m_values[*m_keys_iter];
+    }
+
+    const value_type* operator->() const
+    {
+      return &m_map->m_values[*m_keys_iter];
+    }
+
+    const_iterator& operator++() { ++m_keys_iter; return *this; }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return m_keys_iter == other.m_keys_iter;
+    }
+
+    bool operator!=(const const_iterator& other) const
+    {
+      return m_keys_iter != other.m_keys_iter;
+    }
+  };
+
+  DenseMap()
+  : m_values(),
+    m_present(),
+    m_keys() {}
+
+  size_t size() const { return m_keys.size(); }
+  bool empty() const { return m_keys.empty(); }
+
+  bool contains(const Key key) const
+  {
+    return key < m_present.size() && m_present[key];
+  }
+
+  T& operator[](const Key key)
+  {
+    if (m_values.size() <= key)
+    {
+      m_values.resize(key + 1);
+      m_present.resize(key + 1, false);
+    }
+
+    if (!m_present[key])
+    {
+      m_present[key] = true;
+      m_values[key].first = key;
+      m_keys.push_back(key);
+    }
+    return m_values[key].second;
+  }
+
+  const T& at(const Key key) const
+  {
+    if (!contains(key))
+      throw std::out_of_range("crv::DenseMap::at");
+
+    return m_values[key].second;
+  }
+
+  /// Keeps the allocated vectors, including those of the values, for reuse
+
+  /// \pre: T has a member function clear()
+  void clear()
+  {
+    for (const Key key : m_keys)
+    {
+      m_present[key] = false;
+      m_values[key].second.clear();
+    }
+    m_keys.clear();
+  }
+
+  const_iterator begin() const { return {this, m_keys.cbegin()}; }
+  const_iterator end() const { return {this, m_keys.cend()}; }
+};
+
+typedef DenseMap<Address, EventKinds> PerAddressMap;
+typedef DenseMap<ThreadIdentifier, EventHandles> PerThreadMap;
+typedef std::unordered_map<EventHandle, EventHandles> PerEventMap;
 
 /// Control flow decision along symbolic path
 struct Flip
@@ -227,13 +485,60 @@ struct Flip
   bool direction;
   bool is_flip;
 
-  Flip(bool direction)
+  // number of events before the control flow decision
+  size_t events_size;
+
+  // if nonzero, least event identifier after the control flow decision
+  EventIdentifier event_id_cnt;
+
+  Flip(bool direction, size_t events_size = 0)
   : direction(direction),
-    is_flip(false) {}
+    is_flip(false),
+    events_size(events_size),
+    event_id_cnt(0) {}
+};
+
+/// Constrains an activation literal of a guard, see Tracer::guard()
+struct GuardDefinition
+{
+  // number of events before the control flow decision
+  size_t events_size;
+
+  // literal == (previous literal and condition)
+  smt::Bool definition;
 };
 
+typedef std::vector<GuardDefinition> GuardDefinitions;
+
 typedef std::list<Flip> FlipList;
 typedef std::list<Flip>::const_iterator FlipIter;
+
+/// Control flow decisions from the beginning of a symbolic path
+typedef std::vector<bool> Directions;
+
+/// Orders in which Tracer::flip() explores symbolic paths
+enum SearchStrategy : unsigned short
+{
+  /// Flip the last guard along the current path that has not been
+  /// flipped yet, which keeps the most events of the previous path
+  DFS_SEARCH = 0,
+
+  /// Explore the subtree below the earliest unexplored guard direction
+  BFS_SEARCH,
+
+  /// Pick an unexplored subtree uniformly at random, which amounts to
+  /// a random restart after every path, see Tracer::set_seed()
+  RANDOM_SEARCH,
+
+  /// Pick the unexplored guard direction that previous paths have
+  /// taken least often. Guards are told apart by the number of events
+  /// before them, which approximates their location in the program.
+  COVERAGE_SEARCH,
+};
+
+/// Number of events per thread identifier, see Tracer::happens_before()
+typedef std::vector<unsigned> VectorClock;
+typedef std::vector<ThreadIdentifier> ThreadIdentifiers;
 typedef std::list<smt::Bool> Bools;
 
 template<typename T> class External;
@@ -253,20 +558,62 @@ class Tracer
 {
 private:
   static const std::string s_value_prefix;
+  static const std::string s_guard_prefix;
 
   EventIdentifier m_event_id_cnt;
   ThreadIdentifier m_thread_id_cnt;
+
+  // identifiers below are used by previously explored paths
+  EventIdentifier m_event_id_max;
+
   EventList m_events;
 
+  // see prefix_events_size()
+  unsigned long long m_trace_cnt;
+  size_t m_prefix_events_size;
+
   // Index event list by various keys
   PerAddressMap m_per_address_map;
   PerThreadMap m_per_thread_map;
 
+  // A thread's vector clock only changes in other threads' entries
+  // when it synchronizes, so every event stores the count of its own
+  // thread and the clock that its thread had after synchronizing last
+  struct EventClock
+  {
+    unsigned count;
+    unsigned snapshot;
+  };
+
+  struct ThreadClock
+  {
+    VectorClock clock;
+    unsigned snapshot;
+
+    void clear()
+    {
+      clock.clear();
+      snapshot = 0;
+    }
+  };
+
+  // indexed by event handle, see happens_before()
+  std::vector<EventClock> m_event_clocks;
+
+  // first element is the empty clock of unsynchronized threads
+  std::vector<VectorClock> m_clock_snapshots;
+  DenseMap<ThreadIdentifier, ThreadClock> m_thread_clocks;
+
   // always nonempty
   std::stack<ThreadIdentifier> m_thread_id_stack;
 
-  // never null
+  // never null, either true or the last activation literal
   smt::Bool m_guard;
+  GuardDefinitions m_guard_definitions;
+
+  // identifier of m_guard in m_events if m_is_guard_interned
+  GuardIdentifier m_guard_id;
+  bool m_is_guard_interned;
 
   unsigned long long m_flip_cnt;
   FlipList m_flips;
@@ -276,12 +623,55 @@ private:
 
   Address m_next_address;
 
+  // if non-null, holds the first m_guard_scopes guard definitions,
+  // each in its own scope, see set_guard_solver()
+  smt::Solver* m_guard_solver;
+  size_t m_guard_scopes;
+  unsigned long long m_prune_cnt;
+
+  SearchStrategy m_search_strategy;
+
+  // unexplored subtrees whose last guard is flipped, see flip()
+  std::vector<FlipList> m_pending_flips;
+
+  // number of times that guard directions have been taken
+  std::unordered_map<uint64_t, unsigned long long> m_coverage;
+  std::mt19937_64 m_random;
+
+  // zero means unbounded
+  size_t m_depth_bound;
+  unsigned long long m_flip_budget;
+  std::chrono::steady_clock::duration m_time_budget;
+
+  std::chrono::steady_clock::time_point m_search_start;
+  bool m_is_budget_exhausted;
+
+  // Moves unexplored subtrees along the current path to
+  // m_pending_flips and replaces the current path by one of them
+  bool pop_pending_flips(size_t& flip_index);
+
+  static uint64_t coverage_key(size_t events_size, bool direction)
+  {
+    return (static_cast<uint64_t>(events_size) << 1) | direction;
+  }
+
+  // pop guard definitions from the first one at or after the given index
+  void pop_guard_scopes(size_t guard_scopes)
+  {
+    for (; guard_scopes < m_guard_scopes; m_guard_scopes--)
+      m_guard_solver->pop();
+  }
+
+  // Defines the next activation literal as the conjunction of the
+  // current path condition and the given condition
+  void define_guard(const smt::Bool& literal, const smt::Bool& condition);
+
   template<typename T>
   typename Smt<T>::Sort make_value_symbol()
   {
     assert(m_event_id_cnt < std::numeric_limits<EventIdentifier>::max());
-    return smt::any<typename Smt<T>::Sort>(s_value_prefix +
-      std::to_string(m_event_id_cnt++));
+    return smt::any<typename Smt<T>::Sort>(s_value_prefix.c_str(),
+      m_event_id_cnt++);
   }
 
   template<EventKind kind>
@@ -292,12 +682,39 @@ private:
     const smt::UnsafeTerm& offset_term = smt::UnsafeTerm())
   {
     const ThreadIdentifier thread_id(current_thread_id());
-    m_events.push_back(Event(kind, event_id, thread_id,
-      address, guard(), term, offset_term));
+    const EventHandle e_handle(m_events.push_back(Event(kind, event_id,
+      thread_id, address, intern_guard(), term, offset_term)));
+
+    m_per_address_map[address].push_back<kind>(e_handle);
+    m_per_thread_map[thread_id].push_back(e_handle);
 
-    const EventIter e_iter(--m_events.cend());
-    m_per_address_map[e_iter->address].push_back<kind>(e_iter);
-    m_per_thread_map[thread_id].push_back(e_iter);
+    ThreadClock& thread_clock = m_thread_clocks[thread_id];
+    VectorClock& clock = thread_clock.clock;
+    if (clock.size() <= thread_id)
+      clock.resize(thread_id + 1, 0);
+
+    clock[thread_id]++;
+    m_event_clocks.push_back(EventClock{clock[thread_id],
+      thread_clock.snapshot});
+    assert(m_event_clocks.size() == m_events.size());
+  }
+
+  // call whenever a thread's clock changes in another thread's entry
+  void snapshot_clock(ThreadClock& thread_clock)
+  {
+    thread_clock.snapshot = m_clock_snapshots.size();
+    m_clock_snapshots.push_back(thread_clock.clock);
+  }
+
+  // Events of the same guard region share the guard's identifier
+  GuardIdentifier intern_guard()
+  {
+    if (!m_is_guard_interned)
+    {
+      m_guard_id = m_events.push_guard(m_guard);
+      m_is_guard_interned = true;
+    }
+    return m_guard_id;
   }
 
   void push_next_thread_id()
@@ -311,17 +728,38 @@ public:
   Tracer()
   : m_event_id_cnt(0),
     m_thread_id_cnt(1),
+    m_event_id_max(0),
     m_events(),
+    m_trace_cnt(0),
+    m_prefix_events_size(0),
     m_per_address_map(),
     m_per_thread_map(),
+    m_event_clocks(),
+    m_clock_snapshots(1),
+    m_thread_clocks(),
     m_thread_id_stack(),
     m_guard(smt::literal<smt::Bool>(true)),
+    m_guard_definitions(),
+    m_guard_id(0),
+    m_is_guard_interned(false),
     m_flip_cnt(0),
     m_flips(),
     m_flip_iter(m_flips.cbegin()),
     m_assertions(),
     m_errors(),
-    m_next_address(1)
+    m_next_address(1),
+    m_guard_solver(nullptr),
+    m_guard_scopes(0),
+    m_prune_cnt(0),
+    m_search_strategy(DFS_SEARCH),
+    m_pending_flips(),
+    m_coverage(),
+    m_random(),
+    m_depth_bound(0),
+    m_flip_budget(0),
+    m_time_budget(std::chrono::steady_clock::duration::zero()),
+    m_search_start(std::chrono::steady_clock::now()),
+    m_is_budget_exhausted(false)
   {
     m_thread_id_stack.push(m_thread_id_cnt++);
   }
@@ -332,12 +770,25 @@ public:
     return m_thread_id_stack.top();
   }
 
+  /// Activation literal of the path condition
+
+  /// Every control flow decision introduces a fresh Boolean literal
+  /// that is defined once as the conjunction of the previous literal
+  /// and the condition, see guard_definitions(). Since literals are
+  /// named in the order of decisions, a replay after flip() yields the
+  /// same literals and definitions up to the flipped guard.
   const smt::Bool& guard() const
   {
     assert(!m_guard.is_null());
     return m_guard;
   }
 
+  /// Definitions of all activation literals, ordered by events_size
+  const GuardDefinitions& guard_definitions() const
+  {
+    return m_guard_definitions;
+  }
+
   const EventList& events() const
   {
     return m_events;
@@ -353,17 +804,65 @@ public:
     return m_per_thread_map;
   }
 
+  /// Must x happen before or at the same time as y in every execution?
+
+  /// The happens-before relation is induced by program order and the
+  /// synchronization of threads when they begin and are joined.
+  bool happens_before(const EventHandle x, const EventHandle y) const
+  {
+    const ThreadIdentifier thread_id = m_events[x].thread_id;
+    const EventClock& x_clock = m_event_clocks[x];
+    const EventClock& y_clock = m_event_clocks[y];
+    if (m_events[y].thread_id == thread_id)
+      return x_clock.count <= y_clock.count;
+
+    const VectorClock& y_snapshot = m_clock_snapshots[y_clock.snapshot];
+    return thread_id < y_snapshot.size() &&
+      x_clock.count <= y_snapshot[thread_id];
+  }
+
+  /// Groups of threads that can be exchanged in every execution
+
+  /// Threads are symmetric if they append the same events up to the
+  /// renaming of the values of their own reads, their parent spawns
+  /// them one right after another, and joins them in the same order
+  /// (if at all). They must not spawn threads or decide on guards, and
+  /// no other thread, guard, assertion or error may depend on their
+  /// values. Each group lists at least two threads in spawn order.
+  std::vector<ThreadIdentifiers> symmetric_threads() const;
+
+  /// Which addresses may affect guards, assertions or errors?
+
+  /// An address is relevant if a relevant term uses the value of one
+  /// of its reads. Such a read may read from any write to the address,
+  /// so the terms of those writes are relevant, too. Initially, the
+  /// guard definitions, assertions, errors and the terms of all events
+  /// other than reads and writes are relevant. An address is relevant
+  /// as well if one of its reads does not happen after a write to it.
+  ///
+  /// \param term is relevant unless it is null
+  /// \return indexed by address, with at least one element
+  std::vector<bool> relevant_addresses(
+    const smt::UnsafeTerm& term = smt::UnsafeTerm()) const;
+
   void reset_identifiers()
   {
     m_event_id_cnt = 0;
     m_thread_id_cnt = 1;
+    m_event_id_max = 0;
   }
 
   void reset_events()
   {
+    m_trace_cnt++;
+    m_prefix_events_size = 0;
     m_events.clear();
+    m_is_guard_interned = false;
     m_per_address_map.clear();
     m_per_thread_map.clear();
+    m_event_clocks.clear();
+    m_clock_snapshots.resize(1);
+    m_thread_clocks.clear();
 
     while (!m_thread_id_stack.empty())
     {
@@ -375,13 +874,21 @@ public:
   void reset_guard()
   {
     m_guard = smt::literal<smt::Bool>(true);
+    m_guard_definitions.clear();
+    m_is_guard_interned = false;
   }
 
   void reset_flips()
   {
     m_flip_cnt = 0;
+    m_prune_cnt = 0;
     m_flips.clear();
     m_flip_iter = m_flips.cbegin();
+    m_pending_flips.clear();
+    m_coverage.clear();
+    m_search_start = std::chrono::steady_clock::now();
+    m_is_budget_exhausted = false;
+    pop_guard_scopes(0);
   }
 
   void reset_assertions()
@@ -410,31 +917,75 @@ public:
     reset_address();
   }
 
-  /// Depth-first search strategy
+  /// Explore only paths that begin with the given control flow decisions
 
-  /// \return is there more to explore?
+  /// The guards along prefix are never flipped, see flip()
+  void reset(const Directions& prefix)
+  {
+    reset();
+    for (const bool direction : prefix)
+    {
+      m_flips.push_back(Flip(direction));
+      m_flips.back().is_flip = true;
+    }
+    m_flip_iter = m_flips.cbegin();
+  }
+
+  /// Prepare the next path to explore, see set_search_strategy()
+
+  /// \return is there more to explore within budget?
   bool flip()
   {
     m_flip_iter = m_flips.cbegin();
 
-    while (!m_flips.empty() && m_flips.back().is_flip)
+    if ((0 < m_flip_budget && m_flip_budget <= m_flip_cnt) ||
+        (m_time_budget != std::chrono::steady_clock::duration::zero() &&
+         m_time_budget <= std::chrono::steady_clock::now() - m_search_start))
     {
-      m_flips.pop_back();
+      m_is_budget_exhausted = true;
+      return false;
     }
 
-    if (m_flips.empty())
+    // index of the flipped guard, all guards before it are replayed
+    size_t flip_index;
+    if (m_search_strategy == DFS_SEARCH)
+    {
+      while (!m_flips.empty() && m_flips.back().is_flip)
+      {
+        m_flips.pop_back();
+      }
+
+      if (m_flips.empty())
+        return false;
+
+      Flip& flip = m_flips.back();
+      flip.direction = !flip.direction;
+      flip.is_flip = true;
+      flip_index = m_flips.size() - 1;
+    }
+    else if (!pop_pending_flips(flip_index))
       return false;
 
-    Flip& flip = m_flips.back();
-    flip.direction = !flip.direction;
-    flip.is_flip = true;
+    // pop_pending_flips() replaces the current path
+    m_flip_iter = m_flips.cbegin();
     m_flip_cnt++;
 
+    // definitions before the flipped guard are replayed as they are
+    pop_guard_scopes(flip_index);
+
+    // Replaying the path up to the flipped guard reuses identifiers,
+    // whereas events after it get fresh ones, see append_guard()
+    m_event_id_max = std::max(m_event_id_max, m_event_id_cnt);
+    m_event_id_cnt = 0;
+    m_thread_id_cnt = 1;
+
     reset_events();
     reset_guard();
     reset_assertions();
     reset_errors();
     reset_address();
+    m_prefix_events_size = std::next(m_flips.cbegin(),
+      flip_index)->events_size;
     assert(0 < m_flip_cnt);
     assert(!m_flips.empty());
 
@@ -446,6 +997,128 @@ public:
     return m_flip_cnt;
   }
 
+  /// Check at every new guard decision point whether its directions
+  /// are feasible, and never explore those that are not
+
+  /// The solver holds only the definitions of activation literals
+  /// along the current path, one solver scope per guard. The direction
+  /// passed to append_guard() is checked once, with its activation
+  /// literal as the only assumption. If it is infeasible, then the
+  /// other one is taken instead and marked as explored, so flip()
+  /// skips the guard. The other direction of a feasible one is not
+  /// checked; if it is infeasible, the guards after it are pruned on
+  /// the path that flip() explores next. Since replays after flip()
+  /// keep the scopes before the flipped guard, the program must be
+  /// deterministic, see Encoder::set_incremental().
+  ///
+  /// The scopes of the previous solver, if any, are popped. The new
+  /// solver must not hold any assertions and must outlive its use. If
+  /// solver is null, then no feasibility checks are done.
+  void set_guard_solver(smt::Solver* solver)
+  {
+    if (m_guard_solver != nullptr)
+      pop_guard_scopes(0);
+
+    m_guard_solver = solver;
+    m_guard_scopes = 0;
+  }
+
+  /// Number of guard directions that have been found infeasible
+  unsigned long long prune_cnt() const
+  {
+    return m_prune_cnt;
+  }
+
+  /// Order in which flip() explores paths, DFS_SEARCH by default
+
+  /// Other strategies than DFS_SEARCH keep every unexplored subtree
+  /// in memory, and the next path may share fewer leading events with
+  /// the previous one, see prefix_events_size(). Set the strategy
+  /// before exploring any path, e.g. right before reset().
+  void set_search_strategy(SearchStrategy search_strategy)
+  {
+    m_search_strategy = search_strategy;
+  }
+
+  SearchStrategy search_strategy() const
+  {
+    return m_search_strategy;
+  }
+
+  /// Seed the random number generator of RANDOM_SEARCH
+  void set_seed(uint64_t seed)
+  {
+    m_random.seed(seed);
+  }
+
+  /// Never flip guards after the first depth_bound ones along a path
+
+  /// Zero means unbounded. Together with DFS_SEARCH, this is bounded
+  /// depth-first search.
+  void set_depth_bound(size_t depth_bound)
+  {
+    m_depth_bound = depth_bound;
+  }
+
+  size_t depth_bound() const
+  {
+    return m_depth_bound;
+  }
+
+  /// Stop exploring after flip_budget calls of flip() that succeeded
+
+  /// Zero means unbounded, see is_budget_exhausted()
+  void set_flip_budget(unsigned long long flip_budget)
+  {
+    m_flip_budget = flip_budget;
+  }
+
+  /// Stop exploring once time_budget has passed since reset()
+
+  /// Zero means unbounded. The time is only checked by flip(), so the
+  /// current path is always completed, see is_budget_exhausted().
+  void set_time_budget(std::chrono::milliseconds time_budget)
+  {
+    m_time_budget = time_budget;
+  }
+
+  /// Did flip() stop before all paths were explored?
+  bool is_budget_exhausted() const
+  {
+    return m_is_budget_exhausted;
+  }
+
+  /// Incremented whenever events are reset, e.g. by flip()
+  unsigned long long trace_cnt() const
+  {
+    return m_trace_cnt;
+  }
+
+  /// Upper bound on the identifiers of events in the current trace
+
+  /// Identifiers are shared with value symbols, so this can be larger
+  /// than the number of events.
+  EventIdentifier event_id_cnt() const
+  {
+    return m_event_id_cnt;
+  }
+
+  /// Number of leading events that are the same as in the previous trace
+
+  /// If the program is deterministic, then a replay after flip() appends
+  /// exactly the same events (including identifiers) as the previous
+  /// trace up to the flipped guard. The result is zero after reset().
+  size_t prefix_events_size() const
+  {
+    return m_prefix_events_size;
+  }
+
+  /// Guard decision points of the current path
+  const FlipList& flips() const
+  {
+    return m_flips;
+  }
+
   FlipList& flips()
   {
     return m_flips;
@@ -474,6 +1147,22 @@ public:
 
   bool append_guard(const Internal<bool>&, bool direction = true);
 
+  /// Append the current trace to out in a compact binary format
+
+  /// A record consists of all events, guards, assertions and errors,
+  /// including their terms, see smt::BinaryWriter. The result is
+  /// smt::UNSUPPORT_ERROR if a term cannot be written.
+  smt::Error write(std::ostream& out) const;
+
+  /// Replace the current trace by the next record written by write()
+
+  /// The events can be encoded as usual, but flips() are not restored
+  /// and control flow decisions cannot be replayed. Malformed records
+  /// throw std::runtime_error.
+  ///
+  /// \return false if in has no more records
+  bool read(std::istream& in);
+
   /// Returns parent thread identifier
   ThreadIdentifier append_thread_begin_event()
   {
@@ -484,6 +1173,12 @@ public:
     ThreadIdentifier parent_thread_id(current_thread_id());
     push_next_thread_id();
 
+    // child thread begins after everything its parent has done so far
+    const VectorClock parent_clock(m_thread_clocks[parent_thread_id].clock);
+    ThreadClock& thread_clock = m_thread_clocks[current_thread_id()];
+    thread_clock.clock = parent_clock;
+    snapshot_clock(thread_clock);
+
     append_event<THREAD_BEGIN_EVENT>(
       event_id, 0, smt::UnsafeTerm());
     return parent_thread_id;
@@ -502,11 +1197,23 @@ public:
 
   void append_join_event(const ThreadIdentifier thread_id)
   {
-    const EventIter e_iter = m_per_thread_map.at(thread_id).back();
-    assert(e_iter->thread_id != current_thread_id());
+    const Event& e = m_events[m_per_thread_map.at(thread_id).back()];
+    assert(e.thread_id != current_thread_id());
+
+    // everything the child thread has done happens before the join
+    const VectorClock child_clock(m_thread_clocks.at(thread_id).clock);
+    ThreadClock& thread_clock = m_thread_clocks[current_thread_id()];
+    VectorClock& clock = thread_clock.clock;
+    if (clock.size() < child_clock.size())
+      clock.resize(child_clock.size(), 0);
+
+    for (size_t i = 0; i < child_clock.size(); i++)
+      clock[i] = std::max(clock[i], child_clock[i]);
+
+    snapshot_clock(thread_clock);
 
     append_event<THREAD_END_EVENT>(
-      e_iter->event_id, 0, smt::UnsafeTerm());
+      e.event_id, 0, smt::UnsafeTerm());
   }
 
   /// Creates a new term for the read event
@@ -547,6 +1254,62 @@ public:
 // Global for symbolic execution
 extern Tracer& tracer();
 
+namespace internal
+{
+  /// Let tracer() return the given tracer in the calling thread
+
+  /// If tracer is null, then tracer() returns the global tracer.
+  ///
+  /// \return previously set tracer, possibly null
+  Tracer* set_thread_tracer(Tracer* tracer);
+}
+
+/// Scope in which tracer() returns a different tracer
+
+/// The tracer is only installed in the OS thread that constructs the
+/// context, and it is uninstalled when the context is destroyed. So
+/// independent verification jobs can run concurrently in one process,
+/// each in its own OS thread. Contexts can be nested. Outside of any
+/// context, tracer() returns the global tracer.
+///
+/// Symbolic threads (see Thread) run in the OS thread of their parent.
+class TracerContext
+{
+private:
+  // null unless the tracer is owned by this context
+  std::unique_ptr<Tracer> m_tracer_ptr;
+
+  Tracer& m_tracer;
+  Tracer* const m_previous_tracer;
+
+public:
+  /// Install a new tracer
+  TracerContext()
+  : m_tracer_ptr(new Tracer()),
+    m_tracer(*m_tracer_ptr),
+    m_previous_tracer(internal::set_thread_tracer(&m_tracer)) {}
+
+  /// Install the given tracer, which must outlive the context
+  TracerContext(Tracer& tracer)
+  : m_tracer_ptr(nullptr),
+    m_tracer(tracer),
+    m_previous_tracer(internal::set_thread_tracer(&m_tracer)) {}
+
+  TracerContext(const TracerContext&) = delete;
+  TracerContext& operator=(const TracerContext&) = delete;
+
+  ~TracerContext()
+  {
+    Tracer* const tracer = internal::set_thread_tracer(m_previous_tracer);
+    assert(tracer == &m_tracer);
+  }
+
+  Tracer& tracer()
+  {
+    return m_tracer;
+  }
+};
+
 namespace internal
 {
   /// Evaluate built-in arithmetic and boolean expressions
@@ -636,6 +1399,222 @@ namespace internal
       Eval<opcode>::template const_eval<U, V>(std::declval<U>(), std::declval<V>()))
     Type;
   };
+
+  template<typename U>
+  inline bool is_negative(const U arg)
+  {
+    return std::is_signed<U>::value && arg < static_cast<U>(0);
+  }
+
+#if CRV_OVERFLOW_BUILTINS
+  template<typename U, typename V, typename R>
+  inline bool add_overflow(const U larg, const V rarg, R& result)
+  {
+    return __builtin_add_overflow(larg, rarg, &result);
+  }
+
+  template<typename U, typename V, typename R>
+  inline bool sub_overflow(const U larg, const V rarg, R& result)
+  {
+    return __builtin_sub_overflow(larg, rarg, &result);
+  }
+
+  template<typename U, typename V, typename R>
+  inline bool mul_overflow(const U larg, const V rarg, R& result)
+  {
+    return __builtin_mul_overflow(larg, rarg, &result);
+  }
+#else
+  // false if arg is not representable as intmax_t
+  template<typename U>
+  inline bool to_intmax(const U arg, intmax_t& result)
+  {
+    if (!is_negative(arg) && static_cast<uintmax_t>(arg) >
+        static_cast<uintmax_t>(std::numeric_limits<intmax_t>::max()))
+      return false;
+
+    result = static_cast<intmax_t>(arg);
+    return true;
+  }
+
+  // true, like the builtins, if arg is not representable as R
+  template<typename R>
+  inline bool intmax_overflow(const intmax_t arg, R& result)
+  {
+    if (arg < 0 ?
+          !std::is_signed<R>::value ||
+          arg < static_cast<intmax_t>(std::numeric_limits<R>::min()) :
+          static_cast<uintmax_t>(std::numeric_limits<R>::max()) <
+          static_cast<uintmax_t>(arg))
+      return true;
+
+    result = static_cast<R>(arg);
+    return false;
+  }
+
+  template<typename U, typename V, typename R>
+  inline bool add_overflow(const U larg, const V rarg, R& result)
+  {
+    intmax_t x, y;
+    if (!to_intmax(larg, x) || !to_intmax(rarg, y) ||
+        (0 < y ? std::numeric_limits<intmax_t>::max() - y < x :
+                 x < std::numeric_limits<intmax_t>::min() - y))
+      return true;
+
+    return intmax_overflow(x + y, result);
+  }
+
+  template<typename U, typename V, typename R>
+  inline bool sub_overflow(const U larg, const V rarg, R& result)
+  {
+    intmax_t x, y;
+    if (!to_intmax(larg, x) || !to_intmax(rarg, y) ||
+        (0 < y ? x < std::numeric_limits<intmax_t>::min() + y :
+                 std::numeric_limits<intmax_t>::max() + y < x))
+      return true;
+
+    return intmax_overflow(x - y, result);
+  }
+
+  template<typename U, typename V, typename R>
+  inline bool mul_overflow(const U larg, const V rarg, R& result)
+  {
+    intmax_t x, y;
+    if (!to_intmax(larg, x) || !to_intmax(rarg, y))
+      return true;
+
+    const intmax_t min = std::numeric_limits<intmax_t>::min();
+    const intmax_t max = std::numeric_limits<intmax_t>::max();
+    if (0 < x ? (0 < y ? max / y < x : y < min / x) :
+                (0 < y ? x < min / y : x != 0 && y < max / x))
+      return true;
+
+    return intmax_overflow(x * y, result);
+  }
+#endif
+
+  struct NoFold
+  {
+    template<typename U, typename R, class Integral>
+    static bool fold(const U, R&, Integral)
+    {
+      return false;
+    }
+
+    template<typename U, typename V, typename R, class Integral>
+    static bool fold(const U, const V, R&, Integral)
+    {
+      return false;
+    }
+  };
+
+  /// Evaluate integral literals unless the result could differ from
+  /// that of the SMT term, which is over the mathematical integers
+  template<smt::Opcode opcode>
+  struct Fold : NoFold
+  {
+    using NoFold::fold;
+
+    template<typename U, typename R>
+    static bool fold(const U arg, R& result, std::true_type)
+    {
+      result = Eval<opcode>::eval(arg);
+      return true;
+    }
+
+    // usual arithmetic conversions could make a negative operand unsigned
+    template<typename U, typename V, typename R>
+    static bool fold(const U larg, const V rarg, R& result, std::true_type)
+    {
+      if (std::is_unsigned<typename std::common_type<U, V>::type>::value &&
+          (is_negative(larg) || is_negative(rarg)))
+        return false;
+
+      result = Eval<opcode>::eval(larg, rarg);
+      return true;
+    }
+  };
+
+  // the result must be representable in the return type
+  #define FOLD_NO_OVERFLOW(overflow, opcode)                               \
+    template<>                                                             \
+    struct Fold<opcode> : NoFold                                           \
+    {                                                                      \
+      using NoFold::fold;                                                  \
+                                                                           \
+      template<typename U, typename V, typename R>                         \
+      static bool fold(const U larg, const V rarg, R& result,              \
+        std::true_type)                                                    \
+      {                                                                    \
+        return !overflow(larg, rarg, result);                              \
+      }                                                                    \
+    };
+
+  // integer division of negative numbers rounds differently in SMT
+  #define FOLD_NONNEGATIVE_ONLY(opcode)                                    \
+    template<>                                                             \
+    struct Fold<opcode> : NoFold                                           \
+    {                                                                      \
+      using NoFold::fold;                                                  \
+                                                                           \
+      template<typename U, typename V, typename R>                         \
+      static bool fold(const U larg, const V rarg, R& result,              \
+        std::true_type)                                                    \
+      {                                                                    \
+        if (is_negative(larg) || is_negative(rarg) || rarg == 0)           \
+          return false;                                                    \
+                                                                           \
+        result = Eval<opcode>::eval(larg, rarg);                           \
+        return true;                                                       \
+      }                                                                    \
+    };
+
+  // bitwise operations depend on the width of the SMT sort
+  #define FOLD_NEVER(opcode)                                               \
+    template<>                                                             \
+    struct Fold<opcode> : NoFold {};
+
+  FOLD_NO_OVERFLOW      (add_overflow, smt::ADD)
+  FOLD_NO_OVERFLOW      (mul_overflow, smt::MUL)
+  FOLD_NONNEGATIVE_ONLY (smt::QUO)
+  FOLD_NONNEGATIVE_ONLY (smt::REM)
+  FOLD_NEVER            (smt::NOT)
+  FOLD_NEVER            (smt::AND)
+  FOLD_NEVER            (smt::OR)
+  FOLD_NEVER            (smt::XOR)
+
+  template<>
+  struct Fold<smt::SUB> : NoFold
+  {
+    using NoFold::fold;
+
+    template<typename U, typename R>
+    static bool fold(const U arg, R& result, std::true_type)
+    {
+      return !sub_overflow(0, arg, result);
+    }
+
+    template<typename U, typename V, typename R>
+    static bool fold(const U larg, const V rarg, R& result, std::true_type)
+    {
+      return !sub_overflow(larg, rarg, result);
+    }
+  };
+
+  template<smt::Opcode opcode, typename U, typename R>
+  inline bool fold(const U arg, R& result)
+  {
+    return Fold<opcode>::fold(arg, result, std::integral_constant<bool,
+      std::is_integral<U>::value && std::is_integral<R>::value>());
+  }
+
+  template<smt::Opcode opcode, typename U, typename V, typename R>
+  inline bool fold(const U larg, const V rarg, R& result)
+  {
+    return Fold<opcode>::fold(larg, rarg, result, std::integral_constant<bool,
+      std::is_integral<U>::value && std::is_integral<V>::value &&
+      std::is_integral<R>::value>());
+  }
 }
 
 // Returns a new SMT term that can be set equal to another term
@@ -651,38 +1630,70 @@ typename Smt<T>::Sort append_input_event(const External<T>& external)
 template<typename T>
 class Internal
 {
+private:
+  // if true, m_literal is the value of term and built-in
+  // operators may fold it, see crv::internal::Fold
+  bool m_is_literal;
+  T m_literal;
+
 public:
   typename Smt<T>::Sort term;
 
   Internal(const Internal& other)
-  : term(other.term) {}
+  : m_is_literal(other.m_is_literal),
+    m_literal(other.m_literal),
+    term(other.term) {}
 
   Internal(Internal&& other)
-  : term(std::move(other.term)) {}
+  : m_is_literal(other.m_is_literal),
+    m_literal(other.m_literal),
+    term(std::move(other.term)) {}
 
   explicit Internal(typename Smt<T>::Sort&& term_arg)
-  : term(std::move(term_arg)) {}
+  : m_is_literal(false),
+    m_literal(),
+    term(std::move(term_arg)) {}
 
   Internal(T v)
-  : term(smt::literal<typename Smt<T>::Sort>(v)) {}
+  : m_is_literal(true),
+    m_literal(v),
+    term(smt::literal<typename Smt<T>::Sort>(v)) {}
 
   Internal(const External<T>& other)
-  : term()
+  : m_is_literal(false),
+    m_literal(),
+    term()
   {
     term = append_input_event(other);
   }
 
   Internal& operator=(Internal<T>&& other)
   {
+    m_is_literal = other.m_is_literal;
+    m_literal = other.m_literal;
     term = std::move(other.term);
     return *this;
   }
 
   Internal& operator=(const Internal& other)
   {
+    m_is_literal = other.m_is_literal;
+    m_literal = other.m_literal;
     term = other.term;
     return *this;
   }
+
+  bool is_literal() const
+  {
+    return m_is_literal;
+  }
+
+  /// \pre: is_literal()
+  T literal() const
+  {
+    assert(m_is_literal);
+    return m_literal;
+  }
 };
 
 template<typename T> class __External;
@@ -941,6 +1952,11 @@ void Tracer::append_send_event(const External<T>& channel)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, T>::Type>        \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, T>::Type ReturnType;    \
+    ReturnType value;                                                           \
+    if (arg.is_literal() &&                                                     \
+        crv::internal::fold<smt::opcode>(arg.literal(), value))                 \
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(op arg.term);                              \
   }                                                                             \
                                                                                 \
@@ -949,6 +1965,11 @@ void Tracer::append_send_event(const External<T>& channel)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, T>::Type>        \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, T>::Type ReturnType;    \
+    ReturnType value;                                                           \
+    if (arg.is_literal() &&                                                     \
+        crv::internal::fold<smt::opcode>(arg.literal(), value))                 \
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(op std::move(arg.term));                   \
   }                                                                             \
                                                                                 \
@@ -975,6 +1996,11 @@ CRV_BUILTIN_UNARY_OP(~, NOT)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, U, V>::Type>     \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, U, V>::Type ReturnType; \
+    ReturnType value;                                                           \
+    if (larg.is_literal() && rarg.is_literal() &&                               \
+        crv::internal::fold<smt::opcode>(larg.literal(), rarg.literal(), value))\
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(larg.term op rarg.term);                   \
   }                                                                             \
                                                                                 \
@@ -985,6 +2011,11 @@ CRV_BUILTIN_UNARY_OP(~, NOT)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, U, V>::Type>     \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, U, V>::Type ReturnType; \
+    ReturnType value;                                                           \
+    if (larg.is_literal() && rarg.is_literal() &&                               \
+        crv::internal::fold<smt::opcode>(larg.literal(), rarg.literal(), value))\
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(larg.term op std::move(rarg.term));        \
   }                                                                             \
                                                                                 \
@@ -995,6 +2026,11 @@ CRV_BUILTIN_UNARY_OP(~, NOT)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, U, V>::Type>     \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, U, V>::Type ReturnType; \
+    ReturnType value;                                                           \
+    if (larg.is_literal() && rarg.is_literal() &&                               \
+        crv::internal::fold<smt::opcode>(larg.literal(), rarg.literal(), value))\
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(std::move(larg.term) op rarg.term);        \
   }                                                                             \
                                                                                 \
@@ -1005,6 +2041,11 @@ CRV_BUILTIN_UNARY_OP(~, NOT)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, U, V>::Type>     \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, U, V>::Type ReturnType; \
+    ReturnType value;                                                           \
+    if (larg.is_literal() && rarg.is_literal() &&                               \
+        crv::internal::fold<smt::opcode>(larg.literal(), rarg.literal(), value))\
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(                                           \
       std::move(larg.term) op std::move(rarg.term));                            \
   }                                                                             \
@@ -1017,6 +2058,11 @@ CRV_BUILTIN_UNARY_OP(~, NOT)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, U, V>::Type>     \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, U, V>::Type ReturnType; \
+    ReturnType value;                                                           \
+    if (larg.is_literal() &&                                                    \
+        crv::internal::fold<smt::opcode>(larg.literal(), literal, value))       \
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(larg.term op literal);                     \
   }                                                                             \
                                                                                 \
@@ -1028,6 +2074,11 @@ CRV_BUILTIN_UNARY_OP(~, NOT)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, U, V>::Type>     \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, U, V>::Type ReturnType; \
+    ReturnType value;                                                           \
+    if (larg.is_literal() &&                                                    \
+        crv::internal::fold<smt::opcode>(larg.literal(), literal, value))       \
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(std::move(larg.term) op literal);          \
   }                                                                             \
                                                                                 \
@@ -1039,6 +2090,11 @@ CRV_BUILTIN_UNARY_OP(~, NOT)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, U, V>::Type>     \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, U, V>::Type ReturnType; \
+    ReturnType value;                                                           \
+    if (rarg.is_literal() &&                                                    \
+        crv::internal::fold<smt::opcode>(literal, rarg.literal(), value))       \
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(literal op rarg.term);                     \
   }                                                                             \
                                                                                 \
@@ -1050,6 +2106,11 @@ CRV_BUILTIN_UNARY_OP(~, NOT)
   -> crv::Internal<typename crv::internal::Return<smt::opcode, U, V>::Type>     \
   {                                                                             \
     typedef typename crv::internal::Return<smt::opcode, U, V>::Type ReturnType; \
+    ReturnType value;                                                           \
+    if (rarg.is_literal() &&                                                    \
+        crv::internal::fold<smt::opcode>(literal, rarg.literal(), value))       \
+      return crv::Internal<ReturnType>(value);                                  \
+                                                                                \
     return crv::Internal<ReturnType>(literal op std::move(rarg.term));          \
   }                                                                             \
                                                                                 \
@@ -1151,19 +2212,39 @@ CRV_BUILTIN_BINARY_OP(^, XOR)
 namespace crv
 {
 
-#ifdef __BV_TIME__
-typedef smt::Bv<unsigned short> TimeSort;
-#else
-typedef smt::Int TimeSort;
-#endif
+/// Encodings of time and event identifiers, see Encoder
+
+/// The solver logic is chosen to match the encoding, see Encoder::logic()
+enum TimeEncoding : unsigned short
+{
+  /// Integers in linear integer arithmetic, QF_AUFLIA
+  INT_TIME = 0,
+
+  /// Integers whose constraints are all of the form x < y, x <= y,
+  /// x = y or x = n, which is integer difference logic, QF_UFIDL.
+  /// Only suitable for traces whose data constraints are in the same
+  /// logic, otherwise the solver rejects the trace or returns unknown.
+  /// So every value must be a literal or a read plus or minus a literal
+  /// (e.g. `x + 1`), and comparisons may only relate two such values.
+  /// Data arithmetic such as `a + b`, `2 * a`, division or remainder,
+  /// as well as arrays and stacks, require INT_TIME instead.
+  IDL_TIME,
+
+  /// Unsigned bit-vectors of width ceil(log2(n+1)) where n is the
+  /// number of event identifiers of the largest trace encoded so far,
+  /// see Tracer::event_id_cnt(). The logic is QF_AUFBV if data has
+  /// __BIT_PRECISION__, and otherwise ALL since integers are mixed
+  /// with bit-vectors.
+  BV_TIME,
+};
 
 class Time
 {
 private:
-  TimeSort m_term;
+  smt::UnsafeTerm m_term;
 
 public:
-  Time(const TimeSort& term)
+  Time(const smt::UnsafeTerm& term)
   : m_term(term) {}
 
   Time(const Time& other)
@@ -1172,22 +2253,22 @@ public:
   Time(Time&& other)
   : m_term(std::move(other.m_term)) {}
 
-  smt::Bool happens_before(const Time& t) const
+  smt::UnsafeTerm happens_before(const Time& t) const
   {
     return m_term < t.m_term;
   }
 
-  smt::Bool simultaneous(const Time& t) const
+  smt::UnsafeTerm simultaneous(const Time& t) const
   {
     return m_term == t.m_term;
   }
 
-  smt::Bool simultaneous_or_happens_before(const Time& t) const
+  smt::UnsafeTerm simultaneous_or_happens_before(const Time& t) const
   {
     return m_term <= t.m_term;
   }
 
-  const TimeSort& term() const
+  const smt::UnsafeTerm& term() const
   {
     return m_term;
   }
@@ -1199,188 +2280,795 @@ public:
   }
 };
 
+/// Encodings of the from-read (fr) relation, see Encoder
+
+/// A read r and write w' are in the fr relation if r reads from some
+/// write that happens before w'. Write serialization is the order of
+/// the time variables of writes.
+enum FromReadEncoding : unsigned short
+{
+  /// For all reads r, and writes w and w', O(R*W*W) constraints
+  PAIRWISE_FROM_READ = 0,
+
+  /// Each read r has a variable for the time of the write it reads from,
+  /// and no write w' may happen between that time and r, O(R*W)
+  RANK_FROM_READ,
+};
+
 class Encoder
 {
+public:
+  struct Stats
+  {
+    // read-from and from-read constraints that are not encoded
+    // because they are implied by the happens-before relation
+    unsigned long long pruned_rf;
+    unsigned long long pruned_fr;
+
+    // constraints added by lazy encoding, see set_lazy()
+    unsigned long long lazy_fr;
+    unsigned long long lazy_ws;
+    unsigned long long refinements;
+
+    // threads ordered after a symmetric one, see set_symmetry_reduction()
+    unsigned long long symmetric_threads;
+
+    // addresses whose reads and writes are not encoded, see set_slicing()
+    unsigned long long sliced_addresses;
+
+    // addresses whose reads are equated with writes, see set_forwarding()
+    unsigned long long forwarded_addresses;
+  };
+
 private:
   static const std::string s_time_prefix;
   static const std::string s_rf_prefix;
+  static const std::string s_rf_time_prefix;
   static const std::string s_pf_prefix;
   static const std::string s_ldf_prefix;
+  static const std::string s_match_prefix;
+  static const std::string s_finalizer_prefix;
+
+  // Packs two 32-bit identifiers into a single symbol identifier
+  static uint64_t pair_id(uint64_t high, uint64_t low)
+  {
+    assert(high <= std::numeric_limits<uint32_t>::max());
+    assert(low <= std::numeric_limits<uint32_t>::max());
+    return high << 32 | low;
+  }
 
-  static std::string prefix_event_id(
+  // Time or event identifier constant whose symbol is unique per sort
+  smt::UnsafeTerm time_constant(
     const std::string& prefix,
-    const Event& e)
+    const Event& e) const
   {
-    return prefix + std::to_string(e.event_id);
+    // bit-vectors of different width must not share symbols
+    const uint64_t id(m_time_encoding == BV_TIME ?
+      pair_id(m_time_width, e.event_id) : e.event_id);
+
+    return smt::constant(smt::UnsafeDecl(prefix.c_str(), id, *m_time_sort));
   }
 
   // Returns `x == prefix!y`, e.g. `y` reads from `x`
-  static smt::Bool flow_bool(
+  smt::UnsafeTerm flow_bool(
     const std::string& prefix,
     const Event& x,
-    const Event& y)
+    const Event& y) const
   {
     // check that events oppose each other,
     // assuming data flow from x to y.
     assert(x.kind - 1 == y.kind);
 
-    const TimeSort app(smt::any<TimeSort>(
-      prefix_event_id(prefix, y)));
-    return x.event_id == app;
+    const smt::UnsafeTerm app(time_constant(prefix, y));
+    return smt::literal(*m_time_sort, x.event_id) == app;
   }
 
-  smt::CVC4Solver m_solver;
-  std::unordered_map<EventIdentifier, TimeSort> m_time_map;
-  const Time m_epoch;
+  const TimeEncoding m_time_encoding;
+
+  // only non-null if the solver is not injected
+  std::unique_ptr<smt::CVC4Solver> m_cvc4_solver;
+  smt::Solver& m_solver;
+
+  // sort of time variables, and its width if BV_TIME
+  const smt::Sort* m_time_sort;
+  unsigned m_time_width;
+
+  // indexed by event identifier
+  std::vector<smt::UnsafeTerm> m_time_map;
+  Time m_epoch;
+
+  struct Scope
+  {
+    // first event whose constraints are encoded in this scope
+    EventHandle events_begin;
+
+    // identifiers of time variables declared in this scope
+    std::vector<EventIdentifier> event_ids;
+  };
+
+  // solver scopes, one per guard decision point if incremental
+  std::vector<Scope> m_scopes;
+
+  bool m_is_incremental;
+  FromReadEncoding m_from_read_encoding;
+  bool m_is_pruning;
+  bool m_is_lazy;
+  bool m_is_symmetry_reduction;
+  bool m_is_slicing;
+  bool m_is_forwarding;
+  Stats m_stats;
+
+  // indexed by address, empty if all addresses are encoded
+  std::vector<bool> m_relevant_addresses;
+
+  // indexed by address, empty if no reads are forwarded
+  std::vector<bool> m_forwarded_addresses;
+
+  // number of events encoded in m_scopes, see update()
+  unsigned long long m_trace_cnt;
+  EventHandle m_events_size;
 
   /// Uses e's identifier to build a numerical SMT variable
   Time time(const Event& e)
   {
-    TimeSort& time = m_time_map[e.event_id];
+    if (m_time_map.size() <= e.event_id)
+      m_time_map.resize(e.event_id + 1);
+
+    smt::UnsafeTerm& time = m_time_map[e.event_id];
     if (time.is_null())
     {
-      time = smt::any<TimeSort>(prefix_event_id(s_time_prefix, e));
-      m_solver.add(m_epoch.happens_before(time));
+      time = time_constant(s_time_prefix, e);
+      m_solver.unsafe_add(m_epoch.happens_before(time));
+
+      if (!m_scopes.empty())
+        m_scopes.back().event_ids.push_back(e.event_id);
     }
 
     return time;
   }
 
+  void push_scope(const EventHandle events_begin)
+  {
+    m_solver.push();
+    m_scopes.push_back(Scope{events_begin, {}});
+  }
+
+  void pop_scope()
+  {
+    assert(!m_scopes.empty());
+
+    // time variables must be redeclared with their lower bound
+    for (const EventIdentifier event_id : m_scopes.back().event_ids)
+      m_time_map[event_id] = smt::UnsafeTerm();
+
+    m_scopes.pop_back();
+    m_solver.pop();
+  }
+
+  void reset_scopes()
+  {
+    while (!m_scopes.empty())
+      pop_scope();
+
+    m_events_size = 0;
+  }
+
+  // Widen bit-vector time so that the epoch and all event identifiers
+  // of the tracer have distinct values, see BV_TIME
+  void resize_time(const Tracer& tracer)
+  {
+    if (m_time_encoding != BV_TIME)
+      return;
+
+    unsigned time_width = 1;
+    while ((1ULL << time_width) <= tracer.event_id_cnt())
+      time_width++;
+
+    if (time_width <= m_time_width)
+      return;
+
+    reset_scopes();
+    m_time_map.clear();
+    m_time_width = time_width;
+    m_time_sort = &smt::bv_sort(false, time_width);
+    m_epoch = Time(smt::literal(*m_time_sort, 0));
+  }
+
   void unsafe_add(const smt::UnsafeTerm& term)
   {
     m_solver.unsafe_add(term);
 #ifdef __CRV_DEBUG__
-    std::cout << "[crv::Encoder]: " << m_solver.expr() << std::endl;
+    if (m_cvc4_solver)
+      std::cout << "[crv::Encoder]: " << m_cvc4_solver->expr() << std::endl;
 #endif
   }
 
-  void encode_read_from(const PerAddressMap& per_address_map)
+  // Are the reads and writes of the address encoded with time and
+  // flow variables? Not if they are sliced away or forwarded.
+  bool is_relevant(const Address address) const
+  {
+    if (address < m_forwarded_addresses.size() &&
+        m_forwarded_addresses[address])
+      return false;
+
+    return m_relevant_addresses.empty() ||
+      (address < m_relevant_addresses.size() &&
+       m_relevant_addresses[address]);
+  }
+
+  // Events other than reads and writes are always encoded
+  bool is_relevant(const Event& e) const
+  {
+    return (e.kind != READ_EVENT && e.kind != WRITE_EVENT) ||
+      is_relevant(e.address);
+  }
+
+  // Drop the reads and writes that cannot affect the trace's guards,
+  // assertions, errors and the given term, see Tracer::relevant_addresses()
+  void slice(const Tracer& tracer, const smt::UnsafeTerm& term)
+  {
+    m_relevant_addresses.clear();
+    if (!m_is_slicing)
+      return;
+
+    m_relevant_addresses = tracer.relevant_addresses(term);
+    for (const PerAddressMap::value_type& pair : tracer.per_address_map())
+    {
+      const EventKinds& a = pair.second;
+      if (!is_relevant(pair.first) &&
+          !(a.reads().empty() && a.writes().empty()))
+        m_stats.sliced_addresses++;
+    }
+  }
+
+  // Write that r must read from if r reads at all, or null. This is
+  // the case if w happens before r, and every other write happens
+  // before w or after r. Since guards only strengthen along the trace,
+  // r's guard implies w's guard.
+  static const Event* forwarding_write(
+    const Tracer& tracer,
+    const EventHandles& w_handles,
+    const EventHandle r_handle)
+  {
+    // the write that happens before r with the largest handle
+    EventHandles::const_reverse_iterator w_iter = std::find_if(
+      w_handles.crbegin(), w_handles.crend(),
+      [&tracer, r_handle](const EventHandle w_handle)
+      {
+        return w_handle < r_handle &&
+          tracer.happens_before(w_handle, r_handle);
+      });
+
+    if (w_iter == w_handles.crend())
+      return nullptr;
+
+    const EventHandle w_handle = *w_iter;
+    for (const EventHandle w_prime_handle : w_handles)
+    {
+      if (w_prime_handle != w_handle &&
+          !tracer.happens_before(w_prime_handle, w_handle) &&
+          !tracer.happens_before(r_handle, w_prime_handle))
+        return nullptr;
+    }
+    return &tracer.events()[w_handle];
+  }
+
+  // Equate every read of an address with the write that it must read
+  // from, e.g. if only one thread accesses the address or it is written
+  // once before other threads are spawned. Such reads and writes need
+  // neither time nor flow variables, see is_relevant().
+  void forward(const Tracer& tracer)
+  {
+    m_forwarded_addresses.clear();
+    if (!m_is_forwarding)
+      return;
+
+    const EventList& events = tracer.events();
+    smt::UnsafeTerm and_fwd(smt::literal<smt::Bool>(true));
+    for (const PerAddressMap::value_type& pair : tracer.per_address_map())
+    {
+      const EventKinds& a = pair.second;
+      if (!is_relevant(pair.first) || a.reads().empty())
+        continue;
+
+      smt::UnsafeTerm and_address_fwd(smt::literal<smt::Bool>(true));
+      bool is_forwarded = true;
+      for (const EventHandle r_handle : a.reads())
+      {
+        const Event* w = forwarding_write(tracer, a.writes(), r_handle);
+        if (w == nullptr)
+        {
+          is_forwarded = false;
+          break;
+        }
+
+        const Event& r = events[r_handle];
+        and_address_fwd = and_address_fwd and
+          smt::implies(events.guard(r.guard_id), w->term == r.term);
+      }
+
+      if (!is_forwarded)
+        continue;
+
+      if (m_forwarded_addresses.size() <= pair.first)
+        m_forwarded_addresses.resize(pair.first + 1, false);
+
+      m_forwarded_addresses[pair.first] = true;
+      and_fwd = and_fwd and and_address_fwd;
+      m_stats.forwarded_addresses++;
+    }
+    unsafe_add(and_fwd);
+  }
+
+  // Are there any events at or after begin?
+  static bool is_recent(const EventHandles& e_handles, EventHandle begin)
+  {
+    return !e_handles.empty() && begin <= e_handles.back();
+  }
+
+  // Is it possible that r reads from w? Pairs that are not are pruned
+  // if w is overwritten by a write w', where w and w' happen before r.
+  bool is_read_from_candidate(
+    const Tracer& tracer,
+    const EventHandles& w_handles,
+    const EventHandle w_handle,
+    const EventHandle r_handle) const
+  {
+    if (!m_is_pruning)
+      return true;
+
+    if (tracer.happens_before(r_handle, w_handle))
+      return false;
+
+    if (!tracer.happens_before(w_handle, r_handle))
+      return true;
+
+    for (const EventHandle w_prime_handle : w_handles)
+    {
+      if (r_handle < w_prime_handle)
+        break;
+
+      if (w_handle != w_prime_handle &&
+          tracer.happens_before(w_handle, w_prime_handle) &&
+          tracer.happens_before(w_prime_handle, r_handle))
+        return false;
+    }
+    return true;
+  }
+
+  // The following encodings with a [begin, end) event range only
+  // encode those constraints whose most recent event is in the range.
+
+  void encode_read_from(
+    const Tracer& tracer,
+    const EventHandle begin,
+    const EventHandle end)
+  {
+    const EventList& events = tracer.events();
+    const PerAddressMap& per_address_map = tracer.per_address_map();
+    smt::UnsafeTerm and_rf(smt::literal<smt::Bool>(true));
+    for (const PerAddressMap::value_type& pair : per_address_map)
+    {
+      const EventKinds& a = pair.second;
+      if (!is_relevant(pair.first))
+        continue;
+
+      if (!is_recent(a.reads(), begin) && !is_recent(a.writes(), begin))
+        continue;
+
+      for (const EventHandle r_handle : a.reads())
+      {
+        if (end <= r_handle)
+          break;
+
+        const Event& r = events[r_handle];
+        for (const EventHandle w_handle : a.writes())
+        {
+          if (end <= w_handle)
+            break;
+
+          if (r_handle < begin && w_handle < begin)
+            continue;
+
+          if (!is_read_from_candidate(tracer, a.writes(), w_handle, r_handle))
+          {
+            m_stats.pruned_rf++;
+            continue;
+          }
+
+          const Event& w = events[w_handle];
+
+          const smt::UnsafeTerm wr_order(time(w).happens_before(time(r)));
+          const smt::UnsafeTerm rf_bool(flow_bool(s_rf_prefix, w, r));
+          const smt::UnsafeTerm wr_equality(w.term == r.term);
+
+          and_rf = and_rf and
+            smt::implies(
+              /* if */ rf_bool,
+              /* then */ wr_order and events.guard(w.guard_id) and wr_equality);
+        }
+      }
+    }
+    unsafe_add(and_rf);
+  }
+
+  // Every read must read from some write, and there can always be
+  // more writes in the future, so this is encoded per trace
+  void encode_read_from_some_write(const Tracer& tracer)
   {
+    const EventList& events = tracer.events();
+    const PerAddressMap& per_address_map = tracer.per_address_map();
     smt::UnsafeTerm and_rf(smt::literal<smt::Bool>(true));
     for (const PerAddressMap::value_type& pair : per_address_map)
     {
       const EventKinds& a = pair.second;
-      for (const EventIter r_iter : a.reads())
+      if (!is_relevant(pair.first))
+        continue;
+
+      for (const EventHandle r_handle : a.reads())
+      {
+        const Event& r = events[r_handle];
+
+        smt::UnsafeTerm or_rf(smt::literal<smt::Bool>(false));
+        for (const EventHandle w_handle : a.writes())
+        {
+          if (!is_read_from_candidate(tracer, a.writes(), w_handle, r_handle))
+            continue;
+
+          const Event& w = events[w_handle];
+          or_rf = flow_bool(s_rf_prefix, w, r) or or_rf;
+        }
+        and_rf = and_rf and events.guard(r.guard_id) and or_rf;
+      }
+    }
+    unsafe_add(and_rf);
+  }
+
+  void encode_pairwise_from_read(
+    const Tracer& tracer,
+    const EventHandle begin,
+    const EventHandle end)
+  {
+    const EventList& events = tracer.events();
+    const PerAddressMap& per_address_map = tracer.per_address_map();
+    smt::UnsafeTerm and_fr(smt::literal<smt::Bool>(true));
+    for (const PerAddressMap::value_type& pair : per_address_map)
+    {
+      const EventKinds& a = pair.second;
+      if (!is_relevant(pair.first))
+        continue;
+
+      if (!is_recent(a.reads(), begin) && !is_recent(a.writes(), begin))
+        continue;
+
+      for (const EventHandle r_handle : a.reads())
+      {
+        if (end <= r_handle)
+          break;
+
+        const Event& r = events[r_handle];
+        for (const EventHandle w_handle : a.writes())
+        {
+          if (end <= w_handle)
+            break;
+
+          if (!is_read_from_candidate(tracer, a.writes(), w_handle, r_handle))
+            continue;
+
+          const bool is_old = r_handle < begin && w_handle < begin;
+          const Event& w = events[w_handle];
+          const smt::UnsafeTerm rf_bool(flow_bool(s_rf_prefix, w, r));
+
+          for (const EventHandle w_prime_handle : a.writes())
+          {
+            if (end <= w_prime_handle)
+              break;
+
+            if (w_handle == w_prime_handle ||
+                (is_old && w_prime_handle < begin))
+              continue;
+
+            // either w' cannot happen after w, or r happens before w'
+            if (m_is_pruning &&
+                (tracer.happens_before(w_prime_handle, w_handle) ||
+                 tracer.happens_before(r_handle, w_prime_handle)))
+            {
+              m_stats.pruned_fr++;
+              continue;
+            }
+
+            const Event& w_prime = events[w_prime_handle];
+            and_fr = and_fr and events.guard(w.guard_id) and
+              smt::implies(
+                /* if */ rf_bool and time(w).happens_before(time(w_prime)),
+                /* then */ time(r).happens_before(time(w_prime)));
+          }
+        }
+      }
+    }
+    unsafe_add(and_fr);
+  }
+
+  void encode_rank_from_read(
+    const Tracer& tracer,
+    const EventHandle begin,
+    const EventHandle end)
+  {
+    const EventList& events = tracer.events();
+    const PerAddressMap& per_address_map = tracer.per_address_map();
+    smt::UnsafeTerm and_fr(smt::literal<smt::Bool>(true));
+    for (const PerAddressMap::value_type& pair : per_address_map)
+    {
+      const EventKinds& a = pair.second;
+      if (!is_relevant(pair.first))
+        continue;
+
+      if (!is_recent(a.reads(), begin) && !is_recent(a.writes(), begin))
+        continue;
+
+      for (const EventHandle r_handle : a.reads())
+      {
+        if (end <= r_handle)
+          break;
+
+        const Event& r = events[r_handle];
+        const Time r_time(time(r));
+
+        // time of the write that r reads from
+        const Time rf_time(time_constant(s_rf_time_prefix, r));
+
+        for (const EventHandle w_handle : a.writes())
+        {
+          if (end <= w_handle)
+            break;
+
+          if (r_handle < begin && w_handle < begin)
+            continue;
+
+          // r happens before w, so r can neither read from w nor can w
+          // happen between r and the write that r reads from
+          if (m_is_pruning && tracer.happens_before(r_handle, w_handle))
+          {
+            m_stats.pruned_fr++;
+            continue;
+          }
+
+          const Event& w = events[w_handle];
+          const Time w_time(time(w));
+
+          if (is_read_from_candidate(tracer, a.writes(), w_handle, r_handle))
+            and_fr = and_fr and events.guard(w.guard_id) and
+              smt::implies(
+                /* if */ flow_bool(s_rf_prefix, w, r),
+                /* then */ rf_time.simultaneous(w_time));
+
+          // no other write may happen between w and r
+          and_fr = and_fr and
+            not (rf_time.happens_before(w_time) and
+              w_time.happens_before(r_time));
+        }
+      }
+    }
+    unsafe_add(and_fr);
+  }
+
+  void encode_from_read(
+    const Tracer& tracer,
+    const EventHandle begin,
+    const EventHandle end)
+  {
+    switch (m_from_read_encoding)
+    {
+    case PAIRWISE_FROM_READ:
+      encode_pairwise_from_read(tracer, begin, end);
+      break;
+    case RANK_FROM_READ:
+      encode_rank_from_read(tracer, begin, end);
+      break;
+    }
+  }
+
+  // Add the fr and ws constraints that the last model violates. The
+  // result is an error if the model cannot be read, e.g. because the
+  // solver has been interrupted.
+  smt::Error refine(const Tracer& tracer, bool& is_refined)
+  {
+    smt::Error err;
+    const EventList& events = tracer.events();
+    const PerAddressMap& per_address_map = tracer.per_address_map();
+
+    // values must be looked up before any constraints are added
+    smt::UnsafeTerms violations;
+    for (const PerAddressMap::value_type& pair : per_address_map)
+    {
+      const EventKinds& a = pair.second;
+      if (!is_relevant(pair.first))
+        continue;
+
+      const EventHandles& w_handles = a.writes();
+      if (w_handles.size() < 2)
+        continue;
+
+      std::vector<long long> w_values(w_handles.size());
+      for (size_t i = 0; i < w_handles.size(); i++)
+      {
+        err = m_solver.get_value(time(events[w_handles[i]]).term(),
+          w_values[i]);
+        if (err)
+          return err;
+      }
+
+      // write serialization
+      for (size_t i = 0; i < w_handles.size(); i++)
+        for (size_t j = i + 1; j < w_handles.size(); j++)
+          if (w_values[i] == w_values[j])
+          {
+            const Event& w = events[w_handles[i]];
+            const Event& w_prime = events[w_handles[j]];
+            violations.push_back(not time(w).simultaneous(time(w_prime)));
+            m_stats.lazy_ws++;
+          }
+
+      // from-read
+      for (const EventHandle r_handle : a.reads())
       {
-        const Event& r = *r_iter;
+        const Event& r = events[r_handle];
+        long long rf_value, r_value;
+        err = m_solver.get_value(time_constant(s_rf_prefix, r), rf_value);
+        if (err)
+          return err;
+
+        err = m_solver.get_value(time(r).term(), r_value);
+        if (err)
+          return err;
+
+        // write that r reads from
+        size_t i = 0;
+        while (i < w_handles.size() &&
+               events[w_handles[i]].event_id != rf_value)
+          i++;
+
+        assert(i < w_handles.size());
+        if (i == w_handles.size())
+          continue;
 
-        smt::UnsafeTerm or_rf(smt::literal<smt::Bool>(false));
-        for (const EventIter w_iter : a.writes())
+        const Event& w = events[w_handles[i]];
+        for (size_t j = 0; j < w_handles.size(); j++)
         {
-          const Event& w = *w_iter;
-
-          const smt::Bool wr_order(time(w).happens_before(time(r)));
-          const smt::Bool rf_bool(flow_bool(s_rf_prefix, w, r));
-          const smt::UnsafeTerm wr_equality(w.term == r.term);
+          if (i == j || w_values[j] <= w_values[i] || r_value < w_values[j])
+            continue;
 
-          or_rf = rf_bool or or_rf;
-          and_rf = and_rf and
+          const Event& w_prime = events[w_handles[j]];
+          violations.push_back(
             smt::implies(
-              /* if */ rf_bool,
-              /* then */ wr_order and w.guard and wr_equality);
+              /* if */ flow_bool(s_rf_prefix, w, r) and
+                time(w).happens_before(time(w_prime)),
+              /* then */ time(r).happens_before(time(w_prime))));
+          m_stats.lazy_fr++;
         }
-        and_rf = and_rf and r.guard and or_rf;
       }
     }
-    unsafe_add(and_rf);
+
+    for (const smt::UnsafeTerm& violation : violations)
+      unsafe_add(violation);
+
+    is_refined = !violations.empty();
+    return smt::OK;
   }
 
-  void encode_from_read(const PerAddressMap& per_address_map)
+  // Check, and refine until there is a model or none exists
+  smt::CheckResult solve(const Tracer& tracer)
   {
-    smt::UnsafeTerm and_fr(smt::literal<smt::Bool>(true));
-    for (const PerAddressMap::value_type& pair : per_address_map)
+    smt::CheckResult result = m_solver.check();
+    bool is_refined;
+    while (m_is_lazy && result == smt::sat)
     {
-      const EventKinds& a = pair.second;
-      for (const EventIter r_iter : a.reads())
-      {
-        const Event& r = *r_iter;
+      // without a model, coherence is unknown
+      if (refine(tracer, is_refined))
+        return smt::unknown;
 
-        for (EventIterList::const_iterator writes_iter = a.writes().cbegin();
-             writes_iter != a.writes().cend();
-             writes_iter++)
-        {
-          const Event& w = **writes_iter;
-
-          for (EventIterList::const_iterator writes_prime_iter = a.writes().cbegin();
-               writes_prime_iter != a.writes().cend();
-               writes_prime_iter++)
-          {
-            if (*writes_iter == *writes_prime_iter)
-              continue;
+      if (!is_refined)
+        break;
 
-            const Event& w_prime = **writes_prime_iter;
-            const smt::Bool rf_bool(flow_bool(s_rf_prefix, w, r));
-            and_fr = and_fr and w.guard and
-              smt::implies(
-                /* if */ rf_bool and time(w).happens_before(time(w_prime)),
-                /* then */ time(r).happens_before(time(w_prime)));
-          }
-        }
-      }
+      m_stats.refinements++;
+      result = m_solver.check();
     }
-    unsafe_add(and_fr);
+    return result;
   }
 
-  void encode_write_serialization(const PerAddressMap& per_address_map)
+  void encode_write_serialization(
+    const EventList& events,
+    const PerAddressMap& per_address_map,
+    const EventHandle begin,
+    const EventHandle end)
   {
     smt::UnsafeTerm and_ws(smt::literal<smt::Bool>(true));
     for (const PerAddressMap::value_type& pair : per_address_map)
     {
       const EventKinds& a = pair.second;
-      if (a.writes().size() < 2)
+      if (!is_relevant(pair.first))
         continue;
 
-      smt::UnsafeTerms terms;
-      terms.reserve(a.writes().size());
-      for (const EventIter w_iter : a.writes())
+      if (a.writes().size() < 2 || !is_recent(a.writes(), begin))
+        continue;
+
+      if (begin == 0)
       {
-        const Event& w = *w_iter;
-        terms.push_back(time(w).term());
+        smt::UnsafeTerms terms;
+        terms.reserve(a.writes().size());
+        for (const EventHandle w_handle : a.writes())
+        {
+          if (end <= w_handle)
+            break;
+
+          const Event& w = events[w_handle];
+          terms.push_back(time(w).term());
+        }
+
+        if (terms.size() < 2)
+          continue;
+
+        and_ws = and_ws and smt::distinct(std::move(terms));
+        continue;
       }
 
-      and_ws = and_ws and smt::distinct(std::move(terms));
+      // pairwise distinct with respect to all previous writes
+      for (const EventHandle w_prime_handle : a.writes())
+      {
+        if (end <= w_prime_handle)
+          break;
+
+        if (w_prime_handle < begin)
+          continue;
+
+        const Event& w_prime = events[w_prime_handle];
+        for (const EventHandle w_handle : a.writes())
+        {
+          if (w_prime_handle <= w_handle)
+            break;
+
+          const Event& w = events[w_handle];
+          and_ws = and_ws and not time(w).simultaneous(time(w_prime));
+        }
+      }
     }
     unsafe_add(and_ws);
   }
 
-  void encode_memory_concurrency(const Tracer& tracer)
-  {
-    const PerAddressMap& per_address_map = tracer.per_address_map();
-    encode_read_from(per_address_map);
-    encode_from_read(per_address_map);
-    encode_write_serialization(per_address_map);
-  }
-
-  void encode_pop_from(const PerAddressMap& per_address_map)
+  void encode_pop_from(
+    const EventList& events,
+    const PerAddressMap& per_address_map)
   {
     smt::UnsafeTerm and_pf(smt::literal<smt::Bool>(true));
     for (const PerAddressMap::value_type& pair : per_address_map)
     {
       const EventKinds& a = pair.second;
-      for (const EventIter pop_iter : a.pops())
+      for (const EventHandle pop_handle : a.pops())
       {
-        const Event& pop = *pop_iter;
+        const Event& pop = events[pop_handle];
 
         smt::UnsafeTerm or_pf(smt::literal<smt::Bool>(false));
-        for (const EventIter push_iter : a.pushes())
+        for (const EventHandle push_handle : a.pushes())
         {
-          const Event& push = *push_iter;
-          const smt::Bool pf_bool(flow_bool(s_pf_prefix, push, pop));
+          const Event& push = events[push_handle];
+          const smt::UnsafeTerm pf_bool(flow_bool(s_pf_prefix, push, pop));
           or_pf = pf_bool or or_pf;
           and_pf = and_pf and
             smt::implies(
               /* if */ pf_bool,
               /* then */ time(push).happens_before(time(pop)) and
-                         push.guard and push.term == pop.term);
+                         events.guard(push.guard_id) and push.term == pop.term);
         }
-        and_pf = and_pf and pop.guard and or_pf;
+        and_pf = and_pf and events.guard(pop.guard_id) and or_pf;
       }
     }
     unsafe_add(and_pf);
   }
 
   // Make sure "pop-from" is like an injective function
-  void encode_pop_from_injectivity(const PerAddressMap& per_address_map)
+  void encode_pop_from_injectivity(
+    const EventList& events,
+    const PerAddressMap& per_address_map)
   {
     smt::UnsafeTerm and_pop_excl(smt::literal<smt::Bool>(true));
     for (const PerAddressMap::value_type& pair : per_address_map)
@@ -1389,12 +3077,12 @@ private:
       if (a.pops().size() < 2)
         continue;
 
-      smt::Terms<TimeSort> terms(a.pops().size());
-      for (const EventIter pop_iter : a.pops())
+      smt::UnsafeTerms terms;
+      terms.reserve(a.pops().size());
+      for (const EventHandle pop_handle : a.pops())
       {
-        const Event& pop = *pop_iter;
-        terms.push_back(
-          smt::any<TimeSort>(prefix_event_id(s_pf_prefix, pop)));
+        const Event& pop = events[pop_handle];
+        terms.push_back(time_constant(s_pf_prefix, pop));
       }
 
       and_pop_excl = and_pop_excl and smt::distinct(std::move(terms));
@@ -1402,32 +3090,34 @@ private:
     unsafe_add(and_pop_excl);
   }
 
-  void encode_stack_lifo_order(const PerAddressMap& per_address_map)
+  void encode_stack_lifo_order(
+    const EventList& events,
+    const PerAddressMap& per_address_map)
   {
     smt::UnsafeTerm and_stack(smt::literal<smt::Bool>(true));
     for (const PerAddressMap::value_type& pair : per_address_map)
     {
       const EventKinds& a = pair.second;
-      for (const EventIter push_iter : a.pushes())
+      for (const EventHandle push_handle : a.pushes())
       {
-        const Event& push = *push_iter;
+        const Event& push = events[push_handle];
 
-        for (const EventIter push_prime_iter : a.pushes())
+        for (const EventHandle push_prime_handle : a.pushes())
         {
-          const Event& push_prime = *push_prime_iter;
-          const smt::Bool pushes_order(
+          const Event& push_prime = events[push_prime_handle];
+          const smt::UnsafeTerm pushes_order(
             time(push).happens_before(time(push_prime)));
 
-          for (const EventIter pop_iter : a.pops())
+          for (const EventHandle pop_handle : a.pops())
           {
-            const Event& pop = *pop_iter;
-            const smt::Bool pf_bool(flow_bool(s_pf_prefix, push, pop));
+            const Event& pop = events[pop_handle];
+            const smt::UnsafeTerm pf_bool(flow_bool(s_pf_prefix, push, pop));
 
             smt::UnsafeTerm or_pp(smt::literal<smt::Bool>(false));
-            for (const EventIter pop_prime_iter : a.pops())
+            for (const EventHandle pop_prime_handle : a.pops())
             {
-              const Event& pop_prime = *pop_prime_iter;
-              const smt::Bool pf_prime_bool(
+              const Event& pop_prime = events[pop_prime_handle];
+              const smt::UnsafeTerm pf_prime_bool(
                 flow_bool(s_pf_prefix, push_prime, pop_prime)),
                 pops_order(time(pop_prime).happens_before(time(pop)));
 
@@ -1447,8 +3137,9 @@ private:
             // pf!pop' = push' (and t!pop' < t!pop by "pop-from").
             and_stack = and_stack and
               smt::implies(
-                pf_bool and push_prime.guard and pushes_order and
-                time(push_prime).happens_before(time(pop)), or_pp);
+                pf_bool and events.guard(push_prime.guard_id) and
+                pushes_order and time(push_prime).happens_before(time(pop)),
+                or_pp);
           }
         }
       }
@@ -1459,33 +3150,36 @@ private:
   // Encode partial order model of stack abstract data type (ADT)
   void encode_stack_api(const Tracer& tracer)
   {
+    const EventList& events = tracer.events();
     const PerAddressMap& per_address_map = tracer.per_address_map();
-    encode_pop_from(per_address_map);
-    encode_pop_from_injectivity(per_address_map);
-    encode_stack_lifo_order(per_address_map);
+    encode_pop_from(events, per_address_map);
+    encode_pop_from_injectivity(events, per_address_map);
+    encode_stack_lifo_order(events, per_address_map);
   }
 
   // Similar to "read-from" axiom except that offsets must be equal and
   // loads from initial array return zero
-  void encode_load_from(const PerAddressMap& per_address_map)
+  void encode_load_from(
+    const EventList& events,
+    const PerAddressMap& per_address_map)
   {
     smt::UnsafeTerm and_ldf(smt::literal<smt::Bool>(true));
     for (const PerAddressMap::value_type& pair : per_address_map)
     {
       const EventKinds& a = pair.second;
-      for (const EventIter ld_iter : a.loads())
+      for (const EventHandle ld_handle : a.loads())
       {
-        const Event& ld = *ld_iter;
+        const Event& ld = events[ld_handle];
         const Time& ld_time = time(ld);
 
         smt::UnsafeTerm and_lds(smt::literal<smt::Bool>(true));
         smt::UnsafeTerm or_ldf(smt::literal<smt::Bool>(false));
-        for (const EventIter s_iter : a.stores())
+        for (const EventHandle s_handle : a.stores())
         {
-          const Event& s = *s_iter;
+          const Event& s = events[s_handle];
 
-          const smt::Bool sld_order(time(s).happens_before(ld_time));
-          const smt::Bool ldf_bool(flow_bool(s_ldf_prefix, s, ld));
+          const smt::UnsafeTerm sld_order(time(s).happens_before(ld_time));
+          const smt::UnsafeTerm ldf_bool(flow_bool(s_ldf_prefix, s, ld));
           const smt::UnsafeTerm sld_equality(s.term == ld.term);
 
           // for every store s, if ld and s access the same array
@@ -1499,13 +3193,13 @@ private:
           and_ldf = and_ldf and
             smt::implies(
               /* if */ ldf_bool,
-              /* then */ sld_order and s.guard and
+              /* then */ sld_order and events.guard(s.guard_id) and
                 sld_equality and s.offset_term == ld.offset_term);
         }
 
         /* initial array elements are zero */
         smt::UnsafeTerm ld_zero(smt::literal(ld.term.sort(), 0));
-        and_ldf = and_ldf and ld.guard and smt::implies(
+        and_ldf = and_ldf and events.guard(ld.guard_id) and smt::implies(
           /* if */ not or_ldf,
           /* then */ and_lds and ld.term == std::move(ld_zero));
       }
@@ -1514,28 +3208,30 @@ private:
   }
 
   // Similar to "from-read" axiom except that offsets must be equal
-  void encode_from_load(const PerAddressMap& per_address_map)
+  void encode_from_load(
+    const EventList& events,
+    const PerAddressMap& per_address_map)
   {
     smt::UnsafeTerm and_fld(smt::literal<smt::Bool>(true));
     for (const PerAddressMap::value_type& pair : per_address_map)
     {
       const EventKinds& a = pair.second;
-      for (const EventIter ld_iter : a.loads())
+      for (const EventHandle ld_handle : a.loads())
       {
-        const Event& ld = *ld_iter;
+        const Event& ld = events[ld_handle];
 
-        for (const EventIter s_iter : a.stores())
+        for (const EventHandle s_handle : a.stores())
         {
-          const Event& s = *s_iter;
+          const Event& s = events[s_handle];
 
-          for (const EventIter s_prime_iter : a.stores())
+          for (const EventHandle s_prime_handle : a.stores())
           {
-            if (s_iter == s_prime_iter)
+            if (s_handle == s_prime_handle)
               continue;
 
-            const Event& s_prime = *s_prime_iter;
-            const smt::Bool ldf_bool(flow_bool(s_ldf_prefix, s, ld));
-            and_fld = and_fld and s.guard and
+            const Event& s_prime = events[s_prime_handle];
+            const smt::UnsafeTerm ldf_bool(flow_bool(s_ldf_prefix, s, ld));
+            and_fld = and_fld and events.guard(s.guard_id) and
               smt::implies(
                 /* if */ ldf_bool and time(s).happens_before(time(s_prime)) and
                          s.offset_term == s_prime.offset_term,
@@ -1548,7 +3244,9 @@ private:
   }
 
   // Serialize every store regardless of array offset
-  void encode_store_serialization(const PerAddressMap& per_address_map)
+  void encode_store_serialization(
+    const EventList& events,
+    const PerAddressMap& per_address_map)
   {
     smt::UnsafeTerm and_ss(smt::literal<smt::Bool>(true));
     for (const PerAddressMap::value_type& pair : per_address_map)
@@ -1559,9 +3257,9 @@ private:
 
       smt::UnsafeTerms terms;
       terms.reserve(a.stores().size());
-      for (const EventIter s_iter : a.stores())
+      for (const EventHandle s_handle : a.stores())
       {
-        const Event& s = *s_iter;
+        const Event& s = events[s_handle];
         terms.push_back(time(s).term());
       }
 
@@ -1572,14 +3270,16 @@ private:
 
   void encode_array_api(const Tracer& tracer)
   {
+    const EventList& events = tracer.events();
     const PerAddressMap& per_address_map = tracer.per_address_map();
-    encode_load_from(per_address_map);
-    encode_from_load(per_address_map);
-    encode_store_serialization(per_address_map);
+    encode_load_from(events, per_address_map);
+    encode_from_load(events, per_address_map);
+    encode_store_serialization(events, per_address_map);
   }
 
 public:
   static PerEventMap build_predecessors_map(
+    const EventList& events,
     const PerThreadMap& per_thread_map)
   {
     // TODO: implement communication-select feature
@@ -1591,71 +3291,84 @@ public:
       if (pair.first == 1)
         continue;
 
-      const EventIterList& events = pair.second;
-      if (events.empty())
+      const EventHandles& e_handles = pair.second;
+      if (e_handles.empty())
         continue;
 
-      EventIterList::const_reverse_iterator criter(events.crbegin());
-      assert(criter != events.crend());
+      EventHandles::const_reverse_iterator criter(e_handles.crbegin());
+      assert(criter != e_handles.crend());
 
-      EventIter e_iter(*criter);
-      assert(e_iter->is_thread_end());
+      EventHandle e_handle(*criter);
+      assert(events[e_handle].is_thread_end());
 
-      EventIter e_prime_iter(e_iter);
-      for (criter++; criter != events.crend(); criter++)
+      EventHandle e_prime_handle(e_handle);
+      for (criter++; criter != e_handles.crend(); criter++)
       {
-        const EventKind e_kind((*criter)->kind);
+        const EventKind e_kind(events[*criter].kind);
         if (e_kind != RECV_EVENT && e_kind != SEND_EVENT)
           continue;
 
-        e_prime_iter = *criter;
-        EventIterList& predecessors = predecessors_map[e_iter];
+        e_prime_handle = *criter;
+        EventHandles& predecessors = predecessors_map[e_handle];
         if (!is_communication_select)
         {
-          e_iter = e_prime_iter;
-          for (const EventIter p_iter : predecessors)
+          e_handle = e_prime_handle;
+          for (const EventHandle p_handle : predecessors)
           {
-            predecessors_map[p_iter].push_back(e_iter);
+            predecessors_map[p_handle].push_back(e_handle);
           }
         }
-        predecessors.push_back(e_prime_iter); 
+        predecessors.push_back(e_prime_handle); 
       }
 
-      if (e_prime_iter != *events.crbegin())
+      if (e_prime_handle != *e_handles.crbegin())
       {
         // first per-thread communication events have no predecessors
-        assert(e_prime_iter->is_recv() || e_prime_iter->is_send());
-        predecessors_map[e_prime_iter];
+        assert(events[e_prime_handle].is_recv() ||
+               events[e_prime_handle].is_send());
+        predecessors_map[e_prime_handle];
       }
     }
     return predecessors_map;
   }
 
+  struct EventHandlePairHash
+  {
+    size_t operator()(const std::pair<EventHandle, EventHandle>& p) const
+    {
+      static_assert(sizeof(EventHandle) * 2 <= sizeof(uint64_t),
+        "uint64_t must be at least twice as large as crv::EventHandle");
+
+      return std::hash<uint64_t>()(
+        static_cast<uint64_t>(p.first) << (sizeof(EventHandle) * 8) |
+        p.second);
+    }
+  };
+
   /// Maps recv/send events on same channel but in different threads
-  typedef std::unordered_map<std::pair<EventIter, EventIter>,
-    smt::Bool> MatchableMap;
+  typedef std::unordered_map<std::pair<EventHandle, EventHandle>,
+    smt::Bool, EventHandlePairHash> MatchableMap;
 
   static MatchableMap build_matchable_map(
+    const EventList& events,
     const PerAddressMap& per_address_map)
   {
-    const std::string match_prefix("match!{");
     MatchableMap matchable_map;
     for (const PerAddressMap::value_type& pair : per_address_map)
     {
       const EventKinds& a = pair.second;
-      for (const EventIter r_iter : a.recvs())
+      for (const EventHandle r_handle : a.recvs())
       {
-        for (const EventIter s_iter : a.sends())
+        const Event& r = events[r_handle];
+        for (const EventHandle s_handle : a.sends())
         {
-          if (r_iter->thread_id == s_iter->thread_id)
+          const Event& s = events[s_handle];
+          if (r.thread_id == s.thread_id)
             continue;
 
-          std::string match_symbol(match_prefix +
-            std::to_string(r_iter->event_id) + "," +
-            std::to_string(s_iter->event_id) + "}");
-
-          matchable_map[std::make_pair(r_iter, s_iter)] =
-            smt::any<smt::Bool>(std::move(match_symbol));
+          matchable_map[std::make_pair(r_handle, s_handle)] =
+            smt::any<smt::Bool>(s_match_prefix.c_str(),
+              pair_id(r.event_id, s.event_id));
         }
       }
     }
@@ -1664,29 +3377,31 @@ public:
 
 private:
   static smt::Bool communication_preds(
+    const EventList& events,
     const PerAddressMap& per_address_map,
     const MatchableMap& matchable_map,
-    const EventIterList& predecessors)
+    const EventHandles& predecessors)
   {
     smt::Bool and_match(smt::literal<smt::Bool>(true));
-    for (const EventIter e_iter : predecessors)
+    for (const EventHandle e_handle : predecessors)
     {
-      assert(e_iter->is_recv() || e_iter->is_send());
+      const Event& e = events[e_handle];
+      assert(e.is_recv() || e.is_send());
 
-      const EventKinds& a = per_address_map.at(e_iter->address);
-      const EventIterList& matchables = e_iter->is_recv() ?
+      const EventKinds& a = per_address_map.at(e.address);
+      const EventHandles& matchables = e.is_recv() ?
         a.sends() : a.recvs();
 
       smt::Bool or_match(smt::literal<smt::Bool>(false));
-      for (const EventIter e_prime_iter : matchables)
+      for (const EventHandle e_prime_handle : matchables)
       {
-        if (e_iter->thread_id == e_prime_iter->thread_id)
+        if (e.thread_id == events[e_prime_handle].thread_id)
           continue;
 
         const MatchableMap::key_type match_pair(
-          e_iter->is_recv() ?
-            std::make_pair(e_iter, e_prime_iter)
-          : std::make_pair(e_prime_iter, e_iter));
+          e.is_recv() ?
+            std::make_pair(e_handle, e_prime_handle)
+          : std::make_pair(e_prime_handle, e_handle));
 
         or_match = or_match or matchable_map.at(match_pair);
       }
@@ -1697,78 +3412,83 @@ private:
   }
 
   static smt::Bool communication_excl(
+    const EventList& events,
     const PerAddressMap& per_address_map,
     const MatchableMap& matchable_map,
-    const EventIter r_iter,
-    const EventIter s_iter)
+    const EventHandle r_handle,
+    const EventHandle s_handle)
   {
-    assert(r_iter->is_recv());
-    assert(s_iter->is_send());
-    assert(r_iter->thread_id != s_iter->thread_id);
+    const Event& r = events[r_handle];
+    const Event& s = events[s_handle];
+    assert(r.is_recv());
+    assert(s.is_send());
+    assert(r.thread_id != s.thread_id);
 
-    const EventKinds& r_a = per_address_map.at(r_iter->address);
-    const EventKinds& s_a = per_address_map.at(s_iter->address);
+    const EventKinds& r_a = per_address_map.at(r.address);
+    const EventKinds& s_a = per_address_map.at(s.address);
 
     smt::Bool or_match(smt::literal<smt::Bool>(false));
-    for (const EventIter e_iter : r_a.sends())
+    for (const EventHandle e_handle : r_a.sends())
     {
-      if (r_iter->thread_id == e_iter->thread_id || e_iter == s_iter)
+      if (r.thread_id == events[e_handle].thread_id || e_handle == s_handle)
         continue;
 
       or_match = or_match or
-        matchable_map.at(std::make_pair(r_iter, e_iter));
+        matchable_map.at(std::make_pair(r_handle, e_handle));
     }
-    for (const EventIter e_iter : s_a.recvs())
+    for (const EventHandle e_handle : s_a.recvs())
     {
-      if (s_iter->thread_id == e_iter->thread_id || e_iter == r_iter)
+      if (s.thread_id == events[e_handle].thread_id || e_handle == r_handle)
         continue;
 
       or_match = or_match or
-        matchable_map.at(std::make_pair(e_iter, s_iter));
+        matchable_map.at(std::make_pair(e_handle, s_handle));
     }
     return not or_match;
   }
 
   void encode_communication_concurrency(const Tracer& tracer)
   {
+    const EventList& events = tracer.events();
     const PerAddressMap& per_address_map = tracer.per_address_map();
     const PerThreadMap& per_thread_map = tracer.per_thread_map();
-    const std::string finalizer_prefix("finalizer!");
 
-    auto matchable_map(build_matchable_map(per_address_map));
-    auto predecessors_map(build_predecessors_map(per_thread_map));
+    auto matchable_map(build_matchable_map(events, per_address_map));
+    auto predecessors_map(build_predecessors_map(events, per_thread_map));
 
     smt::Bool init_match(smt::literal<smt::Bool>(false));
-    smt::Bool ext_match(smt::literal<smt::Bool>(true));
+    smt::UnsafeTerm ext_match(smt::literal<smt::Bool>(true));
     smt::Bool finalizers(smt::literal<smt::Bool>(true));
 
     for (const PerAddressMap::value_type& pair : per_address_map)
     {
       const EventKinds& a = pair.second;
-      for (const EventIter r_iter : a.recvs())
+      for (const EventHandle r_handle : a.recvs())
       {
-        const Time& r_time = time(*r_iter);
-        for (const EventIter s_iter : a.sends())
+        const Event& r = events[r_handle];
+        const Time& r_time = time(r);
+        for (const EventHandle s_handle : a.sends())
         {
-          if (r_iter->thread_id == s_iter->thread_id)
+          const Event& s = events[s_handle];
+          if (r.thread_id == s.thread_id)
             continue;
 
           const smt::Bool& match_bool(
-            matchable_map.at(std::make_pair(r_iter, s_iter)));
+            matchable_map.at(std::make_pair(r_handle, s_handle)));
 
           smt::Bool rs_ext(match_bool ==
-            (communication_preds(per_address_map, matchable_map,
-               predecessors_map.at(r_iter)) and
-             communication_preds(per_address_map, matchable_map,
-               predecessors_map.at(s_iter)) and
-             communication_excl(per_address_map, matchable_map,
-               r_iter, s_iter)));
+            (communication_preds(events, per_address_map, matchable_map,
+               predecessors_map.at(r_handle)) and
+             communication_preds(events, per_address_map, matchable_map,
+               predecessors_map.at(s_handle)) and
+             communication_excl(events, per_address_map, matchable_map,
+               r_handle, s_handle)));
 
           ext_match = ext_match and rs_ext and
-            (match_bool == r_time.simultaneous(time(*s_iter)));
+            (match_bool == r_time.simultaneous(time(s)));
 
-          if (predecessors_map.at(r_iter).empty() &&
-              predecessors_map.at(s_iter).empty())
+          if (predecessors_map.at(r_handle).empty() &&
+              predecessors_map.at(s_handle).empty())
             init_match = init_match or match_bool;
         }
       }
@@ -1780,15 +3500,16 @@ private:
       if (pair.first == 1)
         continue;
 
-      const EventIter e_iter(pair.second.back());
-      assert(e_iter->is_thread_end());
+      const EventHandle e_handle(pair.second.back());
+      const Event& e = events[e_handle];
+      assert(e.is_thread_end());
 
       smt::Bool finalizer_bool(smt::any<smt::Bool>(
-        finalizer_prefix + std::to_string(e_iter->event_id)));
+        s_finalizer_prefix.c_str(), e.event_id));
       finalizers = finalizers and finalizer_bool;
       ext_match = ext_match and
-        (finalizer_bool == communication_preds(per_address_map,
-           matchable_map, predecessors_map.at(e_iter)));
+        (finalizer_bool == communication_preds(events, per_address_map,
+           matchable_map, predecessors_map.at(e_handle)));
     }
 
     unsafe_add(ext_match);
@@ -1801,41 +3522,79 @@ private:
    * on the fact that time(const Event&) builds an SMT variable whose
    * name is uniquely determined by the event's identifier.
    */
-  void encode_thread_order(const PerThreadMap& per_thread_map)
+  void encode_thread_order(
+    const EventList& events,
+    const PerThreadMap& per_thread_map,
+    const EventHandle begin,
+    const EventHandle end)
   {
-    smt::Bool thread_order(smt::literal<smt::Bool>(true));
+    smt::UnsafeTerm thread_order(smt::literal<smt::Bool>(true));
     for (const PerThreadMap::value_type& pair : per_thread_map)
     {
-      const EventIterList& events = pair.second;
-      if (events.size() < 2)
+      const EventHandles& e_handles = pair.second;
+      if (e_handles.size() < 2 || !is_recent(e_handles, begin))
+        continue;
+
+      // first event that is ordered after a previous one in the range
+      EventHandles::const_iterator e_handles_iter = std::lower_bound(
+        e_handles.cbegin() + 1, e_handles.cend(), begin);
+      if (e_handles_iter == e_handles.cend())
         continue;
 
-      EventIterList::const_iterator events_iter = events.cbegin();
-      EventIter e_iter = *events_iter++;
-      while (events_iter != events.cend())
+      // thread order skips events that are sliced away or forwarded
+      EventHandle e_handle = *(e_handles_iter - 1);
+      bool is_e_relevant = is_relevant(events[e_handle]);
+      while (e_handles_iter != e_handles.cend() && *e_handles_iter < end)
       {
-        thread_order = thread_order and
-          time(*e_iter).happens_before(time(**events_iter));
+        const Event& e_prime = events[*e_handles_iter];
+        if (is_relevant(e_prime))
+        {
+          if (is_e_relevant)
+            thread_order = thread_order and
+              time(events[e_handle]).happens_before(time(e_prime));
 
-        e_iter = *events_iter;
-        events_iter++;
+          e_handle = *e_handles_iter;
+          is_e_relevant = true;
+        }
+        e_handles_iter++;
       }
     }
     unsafe_add(thread_order);
   }
 
-public:
-  Encoder()
-#ifdef __BV_TIME__
-  : m_solver(smt::QF_AUFBV_LOGIC),
-#else
-  : m_solver(smt::QF_AUFLIA_LOGIC),
-#endif
-    m_time_map(),
-    m_epoch(smt::literal<TimeSort>(0)) {}
+  // Times of the events of symmetric threads are in lexicographic
+  // order, see Tracer::symmetric_threads()
+  void encode_symmetry_reduction(const Tracer& tracer)
+  {
+    const EventList& events = tracer.events();
+    const PerThreadMap& per_thread_map = tracer.per_thread_map();
 
-  /// \return Is there at least one error condition to check?
-  void encode(const Tracer& tracer)
+    smt::UnsafeTerm and_lex(smt::literal<smt::Bool>(true));
+    for (const ThreadIdentifiers& thread_ids : tracer.symmetric_threads())
+    {
+      for (size_t i = 1; i < thread_ids.size(); i++)
+      {
+        const EventHandles& x_handles = per_thread_map.at(thread_ids[i - 1]);
+        const EventHandles& y_handles = per_thread_map.at(thread_ids[i]);
+        assert(x_handles.size() == y_handles.size());
+
+        // thread begin and end events synchronize with other threads
+        smt::UnsafeTerm lex(smt::literal<smt::Bool>(true));
+        for (size_t k = x_handles.size() - 2; 0 < k; k--)
+        {
+          const Time x_time(time(events[x_handles[k]]));
+          const Time y_time(time(events[y_handles[k]]));
+          lex = x_time.happens_before(y_time) or
+            (x_time.simultaneous_or_happens_before(y_time) and lex);
+        }
+        and_lex = and_lex and lex;
+        m_stats.symmetric_threads++;
+      }
+    }
+    unsafe_add(and_lex);
+  }
+
+  void encode_path(const Tracer& tracer)
   {
     unsafe_add(tracer.guard());
     for (const smt::Bool& assertion : tracer.assertions())
@@ -1852,23 +3611,380 @@ public:
       }
       unsafe_add(or_error);
     }
+  }
+
+  // Definitions of activation literals whose control flow decision
+  // is after begin events and before end events, see Tracer::guard()
+  void encode_guard_definitions(
+    const Tracer& tracer,
+    const size_t begin,
+    const size_t end)
+  {
+    smt::UnsafeTerm and_guards(smt::literal<smt::Bool>(true));
+    for (const GuardDefinition& guard_definition : tracer.guard_definitions())
+    {
+      if (end <= guard_definition.events_size)
+        break;
+
+      if (begin <= guard_definition.events_size)
+        and_guards = and_guards and guard_definition.definition;
+    }
+    unsafe_add(and_guards);
+  }
+
+  // Constraints that only grow as events are appended
+  void encode_events(
+    const Tracer& tracer,
+    const EventHandle begin,
+    const EventHandle end)
+  {
+    const EventList& events = tracer.events();
+    const PerAddressMap& per_address_map = tracer.per_address_map();
+
+    encode_guard_definitions(tracer, begin, end);
+
+    encode_thread_order(events, tracer.per_thread_map(), begin, end);
+    encode_read_from(tracer, begin, end);
+
+    if (m_is_lazy)
+    {
+      // so that refine() does not need to declare time variables
+      for (const PerAddressMap::value_type& pair : per_address_map)
+      {
+        const EventKinds& a = pair.second;
+        if (!is_relevant(pair.first))
+          continue;
+
+        for (const EventHandle r_handle : a.reads())
+          if (begin <= r_handle && r_handle < end)
+            time(events[r_handle]);
+
+        for (const EventHandle w_handle : a.writes())
+          if (begin <= w_handle && w_handle < end)
+            time(events[w_handle]);
+      }
+      return;
+    }
+
+    encode_from_read(tracer, begin, end);
+    encode_write_serialization(events, per_address_map, begin, end);
+  }
 
-    encode_thread_order(tracer.per_thread_map());
-    encode_memory_concurrency(tracer);
+  // Constraints that must be re-encoded whenever the trace changes
+  void encode_trace(const Tracer& tracer)
+  {
+    // decisions after the last event
+    encode_guard_definitions(tracer, tracer.events().size(),
+      std::numeric_limits<size_t>::max());
+
+    encode_path(tracer);
+    encode_read_from_some_write(tracer);
     encode_stack_api(tracer);
     encode_array_api(tracer);
   }
 
+  /// Pop scopes of events that are not in the trace, encode new events
+  void update(const Tracer& tracer)
+  {
+    const EventHandle events_size = tracer.events().size();
+
+    // events that are still encoded
+    EventHandle prefix_events_size = 0;
+    if (tracer.trace_cnt() == m_trace_cnt)
+      prefix_events_size = m_events_size;
+    else if (tracer.trace_cnt() == m_trace_cnt + 1)
+      prefix_events_size = std::min<size_t>(m_events_size,
+        tracer.prefix_events_size());
+
+    // only for a deterministic program, see set_incremental()
+    prefix_events_size = std::min(prefix_events_size, events_size);
+
+    // the events of the last scope end at m_events_size
+    while (!m_scopes.empty() && prefix_events_size < m_events_size)
+    {
+      m_events_size = m_scopes.back().events_begin;
+      pop_scope();
+    }
+
+    if (m_scopes.empty())
+      m_events_size = 0;
+
+    m_trace_cnt = tracer.trace_cnt();
+
+    // a new scope starts at every guard decision point
+    std::vector<EventHandle> decisions;
+    for (const Flip& flip : tracer.flips())
+    {
+      if (m_events_size <= flip.events_size && flip.events_size < events_size)
+        decisions.push_back(flip.events_size);
+    }
+    decisions.push_back(events_size);
+
+    for (const EventHandle decision : decisions)
+    {
+      if (decision <= m_events_size)
+        continue;
+
+      if (m_scopes.empty() || m_scopes.back().events_begin < m_events_size)
+        push_scope(m_events_size);
+
+      encode_events(tracer, m_events_size, decision);
+      m_events_size = decision;
+    }
+  }
+
+  // Encode tracer in a new solver scope, see pop_scope(). If term is
+  // not null, it is added later and must not be sliced away.
+  void push_trace(
+    const Tracer& tracer,
+    const smt::UnsafeTerm& term = smt::UnsafeTerm())
+  {
+    resize_time(tracer);
+    if (m_is_incremental)
+    {
+      m_relevant_addresses.clear();
+      m_forwarded_addresses.clear();
+      update(tracer);
+      push_scope(tracer.events().size());
+      encode_trace(tracer);
+    }
+    else
+    {
+      push_scope(0);
+      slice(tracer, term);
+      forward(tracer);
+      encode_events(tracer, 0, tracer.events().size());
+      encode_trace(tracer);
+    }
+  }
+
+  // Either cvc4_solver or solver must be null
+  Encoder(
+    smt::CVC4Solver* cvc4_solver,
+    smt::Solver* solver,
+    TimeEncoding time_encoding)
+  : m_time_encoding(time_encoding),
+    m_cvc4_solver(cvc4_solver),
+    m_solver(solver == nullptr ? *cvc4_solver : *solver),
+    m_time_sort(&smt::internal::sort<smt::Int>()),
+    m_time_width(0),
+    m_time_map(),
+    m_epoch(smt::literal<smt::Int>(0)),
+    m_scopes(),
+    m_is_incremental(false),
+    m_from_read_encoding(PAIRWISE_FROM_READ),
+    m_is_pruning(true),
+    m_is_lazy(false),
+    m_is_symmetry_reduction(false),
+    m_is_slicing(false),
+    m_is_forwarding(false),
+    m_stats{0},
+    m_relevant_addresses(),
+    m_forwarded_addresses(),
+    m_trace_cnt(0),
+    m_events_size(0)
+  {
+    assert((cvc4_solver == nullptr) != (solver == nullptr));
+  }
+
+public:
+  /// Time encoding as determined by the __BV_TIME__ macro
+  static constexpr TimeEncoding default_time_encoding()
+  {
+#ifdef __BV_TIME__
+    return BV_TIME;
+#else
+    return INT_TIME;
+#endif
+  }
+
+  /// Solver logic of the given time encoding
+
+  /// An injected solver should be configured with this logic.
+  static smt::Logic logic(TimeEncoding time_encoding)
+  {
+    switch (time_encoding)
+    {
+    case INT_TIME:
+      return smt::QF_AUFLIA_LOGIC;
+    case IDL_TIME:
+      return smt::QF_UFIDL_LOGIC;
+    case BV_TIME:
+#ifdef __BIT_PRECISION__
+      return smt::QF_AUFBV_LOGIC;
+#else
+      // integer data with bit-vector time
+      return smt::ALL_LOGIC;
+#endif
+    }
+    assert(false);
+    return smt::QF_AUFLIA_LOGIC;
+  }
+
+  /// Use CVC4 with the logic of the time encoding
+  Encoder(TimeEncoding time_encoding = default_time_encoding())
+  : Encoder(new smt::CVC4Solver(logic(time_encoding)), nullptr,
+      time_encoding) {}
+
+  /// Use any solver backend, e.g. smt::Z3Solver or smt::MsatSolver
+
+  /// The solver must outlive the encoder and should be configured
+  /// with logic(time_encoding). Its assertion stack is owned by the
+  /// encoder, i.e. all formulas are added and removed by the encoder.
+  Encoder(
+    smt::Solver& solver,
+    TimeEncoding time_encoding = default_time_encoding())
+  : Encoder(nullptr, &solver, time_encoding) {}
+
+  /// Encode across Tracer::flip() only the events after the flipped guard
+
+  /// In incremental mode, the encoder keeps a solver scope per guard
+  /// decision point of the last checked trace. When a check follows a
+  /// flip(), only scopes after the flipped guard are popped, and only
+  /// the new events and the constraints they add are encoded. Encodings
+  /// of stacks and arrays, and whether reads read from some write, are
+  /// still encoded per check. This requires a deterministic program,
+  /// i.e. every replay must create the same symbols in the same order.
+  void set_incremental(bool is_incremental)
+  {
+    reset_scopes();
+    m_is_incremental = is_incremental;
+  }
+
+  bool is_incremental() const
+  {
+    return m_is_incremental;
+  }
+
+  void set_from_read_encoding(FromReadEncoding from_read_encoding)
+  {
+    reset_scopes();
+    m_from_read_encoding = from_read_encoding;
+  }
+
+  FromReadEncoding from_read_encoding() const
+  {
+    return m_from_read_encoding;
+  }
+
+  /// Drop read-from candidates that contradict program order and
+  /// thread synchronization, see Tracer::happens_before()
+
+  /// Enabled by default
+  void set_happens_before_pruning(bool is_pruning)
+  {
+    reset_scopes();
+    m_is_pruning = is_pruning;
+  }
+
+  /// Encode from-read and write serialization constraints on demand
+
+  /// In lazy mode, the first check() only encodes thread order and the
+  /// read-from relation. As long as the model violates coherence, the
+  /// violated fr and ws constraints are added and the query is solved
+  /// again. The result is the same as with the eager encoding.
+  ///
+  /// Lazy mode reads the model of the solver, so it is refused with
+  /// an error if smt::Solver::enable_models() fails, e.g. because the
+  /// solver is a smt::CachingSolver. In that case, lazy mode is off.
+  smt::Error set_lazy(bool is_lazy)
+  {
+    reset_scopes();
+    m_is_lazy = false;
+    if (is_lazy)
+    {
+      const smt::Error err = m_solver.enable_models();
+      if (err)
+        return err;
+    }
+    m_is_lazy = is_lazy;
+    return smt::OK;
+  }
+
+  bool is_lazy() const
+  {
+    return m_is_lazy;
+  }
+
+  /// Order the events of symmetric threads lexicographically by time
+
+  /// Of all executions that only differ by an exchange of symmetric
+  /// threads, see Tracer::symmetric_threads(), check(const Tracer&)
+  /// considers only one. The result is the same.
+  void set_symmetry_reduction(bool is_symmetry_reduction)
+  {
+    m_is_symmetry_reduction = is_symmetry_reduction;
+  }
+
+  bool is_symmetry_reduction() const
+  {
+    return m_is_symmetry_reduction;
+  }
+
+  /// Encode only the reads and writes that the errors may depend on
+
+  /// The addresses of other reads and writes are not encoded at all,
+  /// and thread order only relates the remaining events. The result is
+  /// the same, see Tracer::relevant_addresses(). Slicing is ignored in
+  /// incremental mode.
+  void set_slicing(bool is_slicing)
+  {
+    reset_scopes();
+    m_is_slicing = is_slicing;
+  }
+
+  bool is_slicing() const
+  {
+    return m_is_slicing;
+  }
+
+  /// Equate reads with the only write that they can read from
+
+  /// If every read of an address happens after a write that is neither
+  /// overwritten by a concurrent write nor by one that happens before
+  /// the read, e.g. the address is accessed by a single thread or only
+  /// written before threads are spawned, its reads and writes are not
+  /// ordered by time variables and no read-from relation is encoded.
+  /// The result is the same. Forwarding is ignored in incremental mode.
+  void set_forwarding(bool is_forwarding)
+  {
+    reset_scopes();
+    m_is_forwarding = is_forwarding;
+  }
+
+  bool is_forwarding() const
+  {
+    return m_is_forwarding;
+  }
+
+  const Stats& stats() const
+  {
+    return m_stats;
+  }
+
+  TimeEncoding time_encoding() const
+  {
+    return m_time_encoding;
+  }
+
+  void encode(const Tracer& tracer)
+  {
+    resize_time(tracer);
+    slice(tracer, smt::UnsafeTerm());
+    forward(tracer);
+    encode_events(tracer, 0, tracer.events().size());
+    encode_trace(tracer);
+  }
+
   /// Check whether there is a communication deadlock
   smt::CheckResult check_deadlock(const Tracer& tracer)
   {
     assert(tracer.errors().empty());
 
-    m_solver.push();
-    encode(tracer);
+    push_trace(tracer);
     encode_communication_concurrency(tracer);
-    const smt::CheckResult result = m_solver.check();
-    m_solver.pop();
+    const smt::CheckResult result = solve(tracer);
+    pop_scope();
     return result;
   }
 
@@ -1882,10 +3998,12 @@ public:
   {
     assert(!tracer.errors().empty());
 
-    m_solver.push();
-    encode(tracer);
-    const smt::CheckResult result = m_solver.check();
-    m_solver.pop();
+    push_trace(tracer);
+    if (m_is_symmetry_reduction)
+      encode_symmetry_reduction(tracer);
+
+    const smt::CheckResult result = solve(tracer);
+    pop_scope();
     return result;
   }
 
@@ -1897,11 +4015,10 @@ public:
     Internal<bool>&& condition,
     const Tracer& tracer)
   {
-    m_solver.push();
+    push_trace(tracer, condition.term);
     unsafe_add(std::move(condition.term));
-    encode(tracer);
-    const smt::CheckResult result = m_solver.check();
-    m_solver.pop();
+    const smt::CheckResult result = solve(tracer);
+    pop_scope();
     return result;
   }
 };
@@ -2010,6 +4127,105 @@ public:
   }
 };
 
+/// Explore symbolic paths of a program in parallel
+
+/// Every worker thread has its own Tracer, which tracer() returns in
+/// that thread, and its own Encoder. A worker explores the subtree of
+/// paths below a prefix of control flow decisions in depth-first order.
+/// Whenever another worker is idle, the busy worker gives away its
+/// least explored subtree, i.e. the one below its earliest guard that
+/// has not been flipped yet.
+///
+/// The program is run once per path, and it must create all symbolic
+/// variables, threads etc. that it uses. Programs that access a shared
+/// SMT solver backend in a way that is not thread-safe must be run with
+/// a single worker.
+class Explorer
+{
+public:
+  typedef std::function<void()> Program;
+
+  /// Creates a solver configured with the given logic, see Encoder
+  typedef std::function<smt::Solver*(smt::Logic)> SolverFactory;
+
+  struct Stats
+  {
+    unsigned long long paths;
+    unsigned long long checks;
+    unsigned long long errors;
+    unsigned long long unknowns;
+    unsigned long long steals;
+    unsigned long long prunes;
+  };
+
+private:
+  const unsigned m_workers;
+  bool m_is_guard_pruning;
+
+  // each worker owns the solvers it creates
+  SolverFactory m_solver_factory;
+
+  // protects all members below
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+
+  // prefixes of unexplored subtrees
+  std::deque<Directions> m_prefixes;
+  unsigned m_idle_workers;
+  bool m_is_done;
+
+  Stats m_stats;
+  std::vector<Directions> m_error_paths;
+
+  bool pop_prefix(Directions& prefix);
+  void share_prefix(Tracer& tracer);
+  void work(const Program& program);
+
+public:
+  /// Use hardware concurrency if workers is zero
+  Explorer(unsigned workers = 0);
+
+  /// Skip guard directions that are infeasible, see
+  /// Tracer::set_guard_solver()
+  void set_guard_pruning(bool is_guard_pruning)
+  {
+    m_is_guard_pruning = is_guard_pruning;
+  }
+
+  bool is_guard_pruning() const
+  {
+    return m_is_guard_pruning;
+  }
+
+  /// Create each worker's encoder and guard solver with the factory
+
+  /// The factory is called concurrently by all workers. By default,
+  /// it creates a smt::CVC4Solver.
+  void set_solver_factory(SolverFactory solver_factory)
+  {
+    assert(solver_factory);
+    m_solver_factory = std::move(solver_factory);
+  }
+
+  /// Run program along every feasible and infeasible path, except
+  /// for infeasible guard directions if is_guard_pruning()
+
+  /// After each path, if there are errors, check whether any of them
+  /// is satisfiable, see Encoder::check(const Tracer&)
+  void explore(const Program& program);
+
+  const Stats& stats() const
+  {
+    return m_stats;
+  }
+
+  /// Control flow decisions of every path with a satisfiable error
+  const std::vector<Directions>& error_paths() const
+  {
+    return m_error_paths;
+  }
+};
+
 }
 
 #endif
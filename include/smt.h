@@ -7,10 +7,14 @@
 
 #include <tuple>
 #include <array>
+#include <mutex>
+#include <atomic>
+#include <future>
 #include <vector>
 #include <string>
 #include <memory>
 #include <cstddef>
+#include <cstring>
 #include <cstdint>
 #include <cassert>
 #include <stdexcept>
@@ -292,6 +296,13 @@ enum Logic : unsigned
   /// Closed formulas built over an arbitrary expansion of the Ints signature
   /// with free sort and function symbols.
   UFNIA_LOGIC,
+
+  /// All Supported Theories
+
+  /// Summary: any combination of theories that the solver supports, e.g.
+  /// integers together with bit-vectors. This is the SMT-LIB 2.6 name for
+  /// a logic that is only restricted by the solver.
+  ALL_LOGIC,
 };
 
 struct Logics
@@ -321,7 +332,8 @@ struct Logics
     "QF_UFLRA",
     "QF_UFNRA",
     "UFLRA",
-    "UFNIA"
+    "UFNIA",
+    "ALL"
   };
 
   Logics() = delete;
@@ -660,7 +672,13 @@ const Sort& bv_sort(bool is_signed, size_t size);
 class UnsafeDecl
 {
 private:
-  const std::string m_symbol;
+  // if m_prefix is non-null, then m_symbol is m_prefix followed by m_id,
+  // but it is only formatted once symbol() is called
+  const char* const m_prefix;
+  const uint64_t m_id;
+  mutable std::once_flag m_symbol_flag;
+  mutable std::atomic<bool> m_is_symbol_formatted;
+  mutable std::string m_symbol;
   const Sort& m_sort;
 
 public:
@@ -668,28 +686,98 @@ public:
   UnsafeDecl(
     const std::string& symbol,
     const Sort& sort)
-  : m_symbol(symbol),
+  : m_prefix(nullptr),
+    m_id(0),
+    m_symbol_flag(),
+    m_is_symbol_formatted(true),
+    m_symbol(symbol),
     m_sort(sort) {}
 
   // Allocate sort statically and use globally unique symbol names!
   UnsafeDecl(
     std::string&& symbol,
     const Sort& sort)
-  : m_symbol(std::move(symbol)),
+  : m_prefix(nullptr),
+    m_id(0),
+    m_symbol_flag(),
+    m_is_symbol_formatted(true),
+    m_symbol(std::move(symbol)),
     m_sort(sort) {}
 
+  // Allocate prefix and sort statically and use unique ids per prefix!
+  UnsafeDecl(
+    const char* const prefix,
+    const uint64_t id,
+    const Sort& sort)
+  : m_prefix(prefix),
+    m_id(id),
+    m_symbol_flag(),
+    m_is_symbol_formatted(false),
+    m_symbol(),
+    m_sort(sort)
+  {
+    assert(prefix != nullptr);
+  }
+
+  // copies of keyed declarations format their own symbol
   UnsafeDecl(const UnsafeDecl& other)
-  : m_symbol(other.m_symbol),
+  : m_prefix(other.m_prefix),
+    m_id(other.m_id),
+    m_symbol_flag(),
+    m_is_symbol_formatted(other.m_prefix == nullptr),
+    m_symbol(other.m_prefix == nullptr ? other.m_symbol : std::string()),
     m_sort(other.m_sort) {}
 
   UnsafeDecl(UnsafeDecl&& other)
-  : m_symbol(std::move(other.m_symbol)),
+  : m_prefix(other.m_prefix),
+    m_id(other.m_id),
+    m_symbol_flag(),
+    m_is_symbol_formatted(other.m_prefix == nullptr),
+    m_symbol(other.m_prefix == nullptr ? std::move(other.m_symbol) :
+      std::string()),
     m_sort(other.m_sort) {}
 
   virtual ~UnsafeDecl() {}
 
+  /// Is the symbol identified by a prefix and an integer?
+  bool is_keyed() const
+  {
+    return m_prefix != nullptr;
+  }
+
+  /// Namespace of a keyed symbol, otherwise nullptr
+  const char* prefix() const
+  {
+    return m_prefix;
+  }
+
+  /// Identifier of a keyed symbol within its namespace
+  uint64_t id() const
+  {
+    assert(is_keyed());
+    return m_id;
+  }
+
+  /// Has symbol() allocated the symbol yet?
+
+  /// Keyed symbols are formatted on the first call of symbol(), so
+  /// declarations that are compared or hashed through prefix() and
+  /// id() never allocate a string.
+  bool is_symbol_formatted() const
+  {
+    return m_is_symbol_formatted;
+  }
+
+  /// Can be called concurrently
   const std::string& symbol() const
   {
+    if (!m_is_symbol_formatted) {
+      std::call_once(m_symbol_flag, [this]()
+      {
+        m_symbol = m_prefix + std::to_string(m_id);
+        m_is_symbol_formatted = true;
+      });
+    }
     return m_symbol;
   }
 
@@ -704,7 +792,16 @@ public:
       return true;
     }
 
-    return m_symbol == other.m_symbol and &m_sort == &other.m_sort;
+    if (&m_sort != &other.m_sort) {
+      return false;
+    }
+
+    if (is_keyed() and other.is_keyed() and
+        std::strcmp(m_prefix, other.m_prefix) == 0) {
+      return m_id == other.m_id;
+    }
+
+    return symbol() == other.symbol();
   }
 };
 
@@ -720,6 +817,10 @@ public:
   Decl(std::string&& symbol)
   : UnsafeDecl(std::move(symbol), internal::sort<T>()) {}
 
+  // Allocate prefix statically and use unique ids per prefix!
+  Decl(const char* const prefix, const uint64_t id)
+  : UnsafeDecl(prefix, id, internal::sort<T>()) {}
+
   Decl(const Decl& other)
   : UnsafeDecl(other) {}
 
@@ -734,6 +835,8 @@ typedef std::vector<UnsafeTerm> UnsafeTerms;
 class Solver
 {
 public:
+  class CheckFuture;
+
   struct Stats
   {
     unsigned constants;
@@ -832,10 +935,86 @@ private:
   virtual Error __unsafe_add(const UnsafeTerm& condition) = 0;
   virtual CheckResult __check() = 0;
 
+  // Solvers that cannot be cloned return null
+  virtual Solver* __clone()
+  {
+    return nullptr;
+  }
+
+  // Called from another thread to stop a running check() as soon as
+  // possible, solvers that cannot be interrupted ignore such requests
+  virtual void __interrupt() {}
+
+  // Solvers without access to a model return UNSUPPORT_ERROR
+  virtual Error __enable_models()
+  {
+    return UNSUPPORT_ERROR;
+  }
+
+  // Solvers without access to a model return UNSUPPORT_ERROR
+  virtual Error __get_value(const UnsafeTerm& term, long long& value)
+  {
+    return UNSUPPORT_ERROR;
+  }
+
+  // Solvers without native support for assumptions check them in
+  // a scope of their own
+  virtual CheckResult __check_assumption(const Bool& assumption)
+  {
+    __push();
+    const Error err = __add(assumption);
+    assert(err == OK);
+    const CheckResult result = err ? unknown : __check();
+    __pop();
+    return result;
+  }
+
+  // check_async() is in flight
+  std::atomic<bool> m_checking;
+
+  // interrupt() has been called since the last check started
+  std::atomic<bool> m_interrupted;
+
+  // check_async() is in the backend's check, guarded by m_check_mutex
+  // so that interrupt() is sent at most once and never to a later check
+  std::mutex m_check_mutex;
+  bool m_is_backend_checking;
+
+  // throws std::logic_error while check_async() is in flight
+  void ensure_idle() const;
+
 protected:
   // Subclasses must have a constructor with a Logic enum value as argument
   Solver()
-  : m_stats{0} {}
+  : m_stats{0},
+    m_checking(false),
+    m_interrupted(false),
+    m_check_mutex(),
+    m_is_backend_checking(false) {}
+
+  // Backends that poll for interrupts (e.g. through a callback)
+  bool is_interrupted() const
+  {
+    return m_interrupted;
+  }
+
+  // Subclasses with their own check functions call this at the start
+  void clear_interrupt()
+  {
+    m_interrupted = false;
+  }
+
+  // Value of the given bits according to get_value()
+  static long long bv_value(const Sort& sort, unsigned long long bits)
+  {
+    assert(sort.is_bv());
+    const size_t size = sort.bv_size();
+    if (sort.is_signed() && 0 < size && size < 64 &&
+        (bits >> (size - 1)) & 1) {
+      bits |= ~0ULL << size;
+    }
+    return static_cast<long long>(bits);
+  }
 
 public:
   Error encode_constant(
@@ -892,9 +1071,117 @@ public:
 
   CheckResult check();
 
+  /// Check the asserted formulas together with the given assumption
+
+  /// Unlike add(), the assumption is not asserted. So consecutive
+  /// checks with different assumptions can reuse what the solver has
+  /// learned about the asserted formulas.
+  CheckResult check_assumption(const Bool& assumption);
+
+  /// Keep a model after check() so that get_value() can be called
+
+  /// Backends that are slower with models (e.g. MathSAT5 and CVC4)
+  /// only keep them once this has been called. It should be called
+  /// before any formulas are added, otherwise some backends fail.
+  /// Returns UNSUPPORT_ERROR if the solver cannot provide models.
+  Error enable_models();
+
+  /// Value of an integer or bit-vector term in the last model
+
+  /// The value of a signed bit-vector is its two's complement value,
+  /// e.g. -1 for `any<Bv<int>>` whose bits are all one. The bits of
+  /// an unsigned bit-vector are returned as they are, so 64-bit values
+  /// above LLONG_MAX are negative.
+  ///
+  /// pre: enable_models() succeeded, the last check() returned sat,
+  ///      and no formulas have been added or scopes popped since
+  Error get_value(const UnsafeTerm& term, long long& value);
+
+  /// Independent solver with identical assertions
+
+  /// All assertions are at the clone's base level, i.e. the clone
+  /// cannot pop() any scopes that have been pushed on this solver.
+  /// Statistics are not copied. The result is null if the solver
+  /// does not support cloning or, as with CVC4Solver, cloning has
+  /// not been enabled.
+  std::unique_ptr<Solver> clone();
+
+  /// Run check() on a separate thread
+
+  /// Until the result is ready, any call that modifies the solver
+  /// (including another check) throws std::logic_error. Terms may
+  /// still be built, but not added, while the check is in flight.
+  CheckFuture check_async();
+
+  /// Is check_async() in flight?
+  bool is_checking() const
+  {
+    return m_checking;
+  }
+
+  /// Ask a running check() to give up
+
+  /// Cancellation is cooperative: the interrupted check() returns
+  /// unknown, but it may also still return sat or unsat if the
+  /// backend finishes before noticing the request. If check_async()
+  /// has not entered the backend yet, it returns unknown without
+  /// running the backend. Otherwise, the backend is interrupted once,
+  /// so a backend that misses the request while it sets up its check
+  /// (as Z3 may) runs that check to completion.
+  void interrupt();
+
   virtual ~Solver() {}
 };
 
+/// Handle to the result of Solver::check_async()
+class Solver::CheckFuture
+{
+private:
+  Solver* m_solver;
+  std::future<CheckResult> m_future;
+
+public:
+  CheckFuture(Solver& solver, std::future<CheckResult>&& future)
+  : m_solver(&solver),
+    m_future(std::move(future)) {}
+
+  CheckFuture(CheckFuture&&) = default;
+  CheckFuture& operator=(CheckFuture&&) = default;
+
+  bool valid() const
+  {
+    return m_future.valid();
+  }
+
+  /// Has the check finished?
+  bool is_ready() const
+  {
+    return m_future.wait_for(std::chrono::seconds(0)) ==
+      std::future_status::ready;
+  }
+
+  void wait() const
+  {
+    m_future.wait();
+  }
+
+  /// Block until the check has finished, can only be called once
+  CheckResult get()
+  {
+    return m_future.get();
+  }
+
+  /// Interrupt the check, see Solver::interrupt()
+  void cancel()
+  {
+    assert(valid());
+    m_solver->interrupt();
+  }
+
+  /// Blocks until the check has finished, unless get() has been called
+  ~CheckFuture() {}
+};
+
 class UnsafeExpr
 {
 private:
@@ -1499,6 +1786,13 @@ T any(const std::string& symbol)
   return constant(Decl<T>(symbol));
 }
 
+// Allocate prefix statically and use unique ids per prefix!
+template<typename T>
+T any(const char* const prefix, const uint64_t id)
+{
+  return constant(Decl<T>(prefix, id));
+}
+
 class UnsafeUnaryExpr : public virtual UnsafeExpr
 {
 private:
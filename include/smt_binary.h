@@ -0,0 +1,644 @@
+// Copyright 2014, Alex Horn. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef __SMT_BINARY_H_
+#define __SMT_BINARY_H_
+
+#include <string>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include "smt.h"
+
+namespace smt
+{
+
+namespace internal
+{
+  // Record tags of the binary term format
+  enum BinaryTag : unsigned char
+  {
+    NULL_TERM_TAG,
+    TERM_REF_TAG,
+    BOOL_LITERAL_TAG,
+    SIGNED_LITERAL_TAG,
+    UNSIGNED_LITERAL_TAG,
+    CONSTANT_TAG,
+    ARRAY_SELECT_TAG,
+    ARRAY_STORE_TAG,
+    UNARY_TAG,
+    BINARY_TAG,
+    NARY_TAG,
+  };
+
+  // Sort tags of the binary term format
+  enum BinarySortTag : unsigned char
+  {
+    BOOL_SORT_TAG,
+    INT_SORT_TAG,
+    REAL_SORT_TAG,
+    BV_SORT_TAG,
+  };
+
+  // Statically typed view of a term that has been read
+  template<typename T>
+  class ReadExpr : public Expr<T>
+  {
+  private:
+    const UnsafeTerm m_term;
+
+    virtual Error __encode(Solver& solver) const override
+    {
+      return m_term.encode(solver);
+    }
+
+  public:
+    ReadExpr(const UnsafeTerm& term)
+    : UnsafeExpr(term.expr_kind(), internal::sort<T>()),
+      Expr<T>(term.expr_kind()),
+      m_term(term) {}
+  };
+}
+
+/// Write term DAGs to a compact binary stream
+
+/// Every shared subterm is written only once, after its operands, as a
+/// node record that is numbered in the order in which it is written.
+/// Operands refer to earlier nodes by their distance to the new node.
+/// Integers are written as variable-length quantities, so small values
+/// take a single byte. Terms whose sort is an array or function sort
+/// (except for array selects and stores) give UNSUPPORT_ERROR.
+///
+/// Since nodes are identified by the address of their expressions, all
+/// written terms must outlive the writer. See BinaryReader.
+class BinaryWriter : public Solver
+{
+private:
+  std::ostream& m_out;
+
+  // node number of every expression that has been written
+  std::unordered_map<uintptr_t, uint64_t> m_node_map;
+  uint64_t m_nodes_size;
+
+  // node number of the most recently visited term
+  uint64_t m_node;
+
+  Error visit(const UnsafeTerm& term)
+  {
+    const std::unordered_map<uintptr_t, uint64_t>::const_iterator iter(
+      m_node_map.find(term.addr()));
+    if (iter != m_node_map.cend()) {
+      m_node = iter->second;
+      return OK;
+    }
+
+    const Error err = term.encode(*this);
+    if (err) {
+      return err;
+    }
+
+    m_node = m_nodes_size++;
+    m_node_map.emplace(term.addr(), m_node);
+    return OK;
+  }
+
+  // Distance from the next node to an earlier node
+  void write_operand(uint64_t node)
+  {
+    assert(node < m_nodes_size);
+    write_uint(m_nodes_size - node);
+  }
+
+  void write_tag(unsigned char tag)
+  {
+    m_out.put(static_cast<char>(tag));
+  }
+
+  Error write_sort(const Sort& sort)
+  {
+    if (sort.is_bool()) {
+      write_tag(internal::BOOL_SORT_TAG);
+    } else if (sort.is_int()) {
+      write_tag(internal::INT_SORT_TAG);
+    } else if (sort.is_real()) {
+      write_tag(internal::REAL_SORT_TAG);
+    } else if (sort.is_bv()) {
+      write_tag(internal::BV_SORT_TAG);
+      write_uint(sort.is_signed());
+      write_uint(sort.bv_size());
+    } else {
+      return UNSUPPORT_ERROR;
+    }
+    return OK;
+  }
+
+  template<typename T>
+  Error write_literal(const Sort& sort, T literal)
+  {
+    if (std::is_same<bool, T>::value) {
+      write_tag(internal::BOOL_LITERAL_TAG);
+    } else if (std::is_signed<T>::value) {
+      write_tag(internal::SIGNED_LITERAL_TAG);
+    } else {
+      write_tag(internal::UNSIGNED_LITERAL_TAG);
+    }
+
+    const Error err = write_sort(sort);
+    if (err) {
+      return err;
+    }
+
+    if (std::is_signed<T>::value) {
+      write_int(static_cast<long long>(literal));
+    } else {
+      write_uint(static_cast<unsigned long long>(literal));
+    }
+    return OK;
+  }
+
+#define SMT_BINARY_ENCODE_BUILTIN_LITERAL(type) \
+  virtual Error __encode_literal(               \
+     const Sort& sort,                          \
+     type literal) override                     \
+  {                                             \
+    return write_literal<type>(sort, literal);  \
+  }                                             \
+
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(bool)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(char)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(signed char)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(unsigned char)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(wchar_t)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(char16_t)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(char32_t)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(short)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(unsigned short)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(int)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(unsigned int)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(long)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(unsigned long)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(long long)
+SMT_BINARY_ENCODE_BUILTIN_LITERAL(unsigned long long)
+
+  virtual Error __encode_constant(
+    const UnsafeDecl& decl) override
+  {
+    write_tag(internal::CONSTANT_TAG);
+    const Error err = write_sort(decl.sort());
+    if (err) {
+      return err;
+    }
+    write_symbol(decl);
+    return OK;
+  }
+
+  virtual Error __encode_func_app(
+    const UnsafeDecl& func_decl,
+    const size_t arity,
+    const UnsafeTerm* const args) override
+  {
+    return UNSUPPORT_ERROR;
+  }
+
+  virtual Error __encode_const_array(
+    const Sort& sort,
+    const UnsafeTerm& init) override
+  {
+    return UNSUPPORT_ERROR;
+  }
+
+  virtual Error __encode_array_select(
+    const UnsafeTerm& array,
+    const UnsafeTerm& index) override
+  {
+    Error err;
+    err = visit(array);
+    if (err) {
+      return err;
+    }
+    const uint64_t array_node = m_node;
+
+    err = visit(index);
+    if (err) {
+      return err;
+    }
+    const uint64_t index_node = m_node;
+
+    write_tag(internal::ARRAY_SELECT_TAG);
+    write_operand(array_node);
+    write_operand(index_node);
+    return OK;
+  }
+
+  virtual Error __encode_array_store(
+    const UnsafeTerm& array,
+    const UnsafeTerm& index,
+    const UnsafeTerm& value) override
+  {
+    Error err;
+    err = visit(array);
+    if (err) {
+      return err;
+    }
+    const uint64_t array_node = m_node;
+
+    err = visit(index);
+    if (err) {
+      return err;
+    }
+    const uint64_t index_node = m_node;
+
+    err = visit(value);
+    if (err) {
+      return err;
+    }
+    const uint64_t value_node = m_node;
+
+    write_tag(internal::ARRAY_STORE_TAG);
+    write_operand(array_node);
+    write_operand(index_node);
+    write_operand(value_node);
+    return OK;
+  }
+
+  virtual Error __encode_unary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerm& arg) override
+  {
+    Error err;
+    err = visit(arg);
+    if (err) {
+      return err;
+    }
+    const uint64_t arg_node = m_node;
+
+    write_tag(internal::UNARY_TAG);
+    write_uint(opcode);
+    err = write_sort(sort);
+    if (err) {
+      return err;
+    }
+    write_operand(arg_node);
+    return OK;
+  }
+
+  virtual Error __encode_binary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerm& larg,
+    const UnsafeTerm& rarg) override
+  {
+    Error err;
+    err = visit(larg);
+    if (err) {
+      return err;
+    }
+    const uint64_t larg_node = m_node;
+
+    err = visit(rarg);
+    if (err) {
+      return err;
+    }
+    const uint64_t rarg_node = m_node;
+
+    write_tag(internal::BINARY_TAG);
+    write_uint(opcode);
+    err = write_sort(sort);
+    if (err) {
+      return err;
+    }
+    write_operand(larg_node);
+    write_operand(rarg_node);
+    return OK;
+  }
+
+  virtual Error __encode_nary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerms& args) override
+  {
+    Error err;
+    std::vector<uint64_t> arg_nodes;
+    arg_nodes.reserve(args.size());
+    for (const UnsafeTerm& arg : args) {
+      err = visit(arg);
+      if (err) {
+        return err;
+      }
+      arg_nodes.push_back(m_node);
+    }
+
+    write_tag(internal::NARY_TAG);
+    write_uint(opcode);
+    err = write_sort(sort);
+    if (err) {
+      return err;
+    }
+    write_uint(arg_nodes.size());
+    for (const uint64_t arg_node : arg_nodes) {
+      write_operand(arg_node);
+    }
+    return OK;
+  }
+
+  virtual void __reset() override
+  {
+    m_node_map.clear();
+    m_nodes_size = 0;
+  }
+
+  virtual void __push() override {}
+  virtual void __pop() override {}
+
+  virtual Error __unsafe_add(const UnsafeTerm& condition) override
+  {
+    return write_term(condition);
+  }
+
+  virtual Error __add(const Bool& condition) override
+  {
+    return write_term(condition);
+  }
+
+  virtual CheckResult __check() override
+  {
+    return unknown;
+  }
+
+protected:
+  /// Symbol of a constant, which BinaryReader reads as a string
+  virtual void write_symbol(const UnsafeDecl& decl)
+  {
+    write_string(decl.symbol());
+  }
+
+public:
+  /// Write to out, nodes are numbered from zero until reset()
+  BinaryWriter(std::ostream& out)
+  : m_out(out),
+    m_node_map(),
+    m_nodes_size(0),
+    m_node(0) {}
+
+  /// Write the nodes of term that have not been written yet,
+  /// followed by a reference to the term, which may be null
+  Error write_term(const UnsafeTerm& term)
+  {
+    if (term.is_null()) {
+      write_tag(internal::NULL_TERM_TAG);
+      return OK;
+    }
+
+    const Error err = visit(term);
+    if (err) {
+      return err;
+    }
+
+    write_tag(internal::TERM_REF_TAG);
+    write_uint(m_nodes_size - m_node);
+    return OK;
+  }
+
+  /// Little-endian base 128
+  void write_uint(uint64_t value)
+  {
+    while (0x80 <= value) {
+      m_out.put(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    m_out.put(static_cast<char>(value));
+  }
+
+  /// Zigzag encoding, so small negative values are short
+  void write_int(int64_t value)
+  {
+    write_uint((static_cast<uint64_t>(value) << 1) ^
+      static_cast<uint64_t>(value >> 63));
+  }
+
+  void write_string(const std::string& str)
+  {
+    write_uint(str.size());
+    m_out.write(str.data(), str.size());
+  }
+
+  uint64_t nodes_size() const
+  {
+    return m_nodes_size;
+  }
+};
+
+/// Read terms written by a BinaryWriter
+
+/// Malformed or truncated input throws std::runtime_error. Constants
+/// are declared with the symbol names that were written, so integer-
+/// keyed symbols are read back as plain symbols of the same name.
+class BinaryReader
+{
+private:
+  std::istream& m_in;
+
+  // indexed by node number
+  UnsafeTerms m_nodes;
+
+  static void fail(const char* what)
+  {
+    throw std::runtime_error(std::string("smt::BinaryReader: ") + what);
+  }
+
+  unsigned char read_tag()
+  {
+    const int c = m_in.get();
+    if (c == std::char_traits<char>::eof()) {
+      fail("unexpected end of stream");
+    }
+    return static_cast<unsigned char>(c);
+  }
+
+  const UnsafeTerm& read_operand()
+  {
+    const uint64_t distance = read_uint();
+    if (distance == 0 || m_nodes.size() < distance) {
+      fail("invalid node reference");
+    }
+    return m_nodes[m_nodes.size() - distance];
+  }
+
+  Opcode read_opcode()
+  {
+    const uint64_t opcode = read_uint();
+    if (GEQ < opcode) {
+      fail("invalid opcode");
+    }
+    return static_cast<Opcode>(opcode);
+  }
+
+  const Sort& read_sort()
+  {
+    switch (read_tag()) {
+    case internal::BOOL_SORT_TAG:
+      return internal::sort<Bool>();
+    case internal::INT_SORT_TAG:
+      return internal::sort<Int>();
+    case internal::REAL_SORT_TAG:
+      return internal::sort<Real>();
+    case internal::BV_SORT_TAG:
+    {
+      const bool is_signed = read_uint();
+      return bv_sort(is_signed, read_uint());
+    }
+    default:
+      fail("invalid sort");
+    }
+    return internal::sort<Bool>();
+  }
+
+  UnsafeTerm read_node(unsigned char tag)
+  {
+    switch (tag) {
+    case internal::BOOL_LITERAL_TAG:
+    {
+      const Sort& sort = read_sort();
+      return literal(sort, static_cast<bool>(read_uint()));
+    }
+    case internal::SIGNED_LITERAL_TAG:
+    {
+      const Sort& sort = read_sort();
+      return literal(sort, static_cast<long long>(read_int()));
+    }
+    case internal::UNSIGNED_LITERAL_TAG:
+    {
+      const Sort& sort = read_sort();
+      return literal(sort, static_cast<unsigned long long>(read_uint()));
+    }
+    case internal::CONSTANT_TAG:
+    {
+      const Sort& sort = read_sort();
+      return constant(UnsafeDecl(read_string(), sort));
+    }
+    case internal::ARRAY_SELECT_TAG:
+    {
+      const UnsafeTerm& array = read_operand();
+      return select(array, read_operand());
+    }
+    case internal::ARRAY_STORE_TAG:
+    {
+      const UnsafeTerm& array = read_operand();
+      const UnsafeTerm& index = read_operand();
+      return store(array, index, read_operand());
+    }
+    case internal::UNARY_TAG:
+    {
+      const Opcode opcode = read_opcode();
+      const Sort& sort = read_sort();
+      return UnsafeTerm(new UnsafeUnaryExpr(sort, opcode, read_operand()));
+    }
+    case internal::BINARY_TAG:
+    {
+      const Opcode opcode = read_opcode();
+      const Sort& sort = read_sort();
+      const UnsafeTerm& larg = read_operand();
+      return UnsafeTerm(new UnsafeBinaryExpr(sort, opcode, larg,
+        read_operand()));
+    }
+    case internal::NARY_TAG:
+    {
+      const Opcode opcode = read_opcode();
+      const Sort& sort = read_sort();
+      const uint64_t args_size = read_uint();
+      if (args_size == 0) {
+        fail("invalid number of operands");
+      }
+
+      UnsafeTerms args;
+      for (uint64_t i = 0; i < args_size; i++) {
+        args.push_back(read_operand());
+      }
+      return UnsafeTerm(new UnsafeNaryExpr(sort, opcode, std::move(args)));
+    }
+    default:
+      fail("invalid tag");
+    }
+    return UnsafeTerm();
+  }
+
+public:
+  BinaryReader(std::istream& in)
+  : m_in(in),
+    m_nodes() {}
+
+  /// Read nodes until the next term reference, see
+  /// BinaryWriter::write_term()
+  UnsafeTerm read_term()
+  {
+    unsigned char tag;
+    while ((tag = read_tag()) != internal::TERM_REF_TAG) {
+      if (tag == internal::NULL_TERM_TAG) {
+        return UnsafeTerm();
+      }
+      m_nodes.push_back(read_node(tag));
+    }
+    return read_operand();
+  }
+
+  /// Like read_term() but fails unless the term is of sort T
+  template<typename T>
+  T read_term()
+  {
+    const UnsafeTerm term(read_term());
+    if (term.is_null() || !(term.sort() == internal::sort<T>())) {
+      fail("unexpected sort");
+    }
+    return T(new internal::ReadExpr<T>(term));
+  }
+
+  uint64_t read_uint()
+  {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      const unsigned char byte = read_tag();
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    fail("integer overflow");
+    return 0;
+  }
+
+  int64_t read_int()
+  {
+    const uint64_t value = read_uint();
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+  }
+
+  std::string read_string()
+  {
+    const uint64_t size = read_uint();
+    std::string str(size, '\0');
+    if (!m_in.read(&str[0], size)) {
+      fail("unexpected end of stream");
+    }
+    return str;
+  }
+
+  /// Forget all nodes, see BinaryWriter::reset()
+  void reset()
+  {
+    m_nodes.clear();
+  }
+
+  uint64_t nodes_size() const
+  {
+    return m_nodes.size();
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,544 @@
+// Copyright 2014, Alex Horn. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef __SMT_CACHE_H_
+#define __SMT_CACHE_H_
+
+#include <list>
+#include <stack>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+
+#include "smt.h"
+
+namespace smt
+{
+
+/// Memoize check() results of another solver
+
+/// Every asserted formula is reduced to a structural hash whose value
+/// depends only on operators, sorts, literals and symbol names but not
+/// on memory addresses. At check(), the hashes of all formulas in all
+/// open scopes are combined into a key that is independent of the
+/// order in which formulas were added. The key is looked up first in
+/// an in-memory LRU cache and then in an optional on-disk cache file,
+/// which is read once at construction and appended to on every miss.
+///
+/// Only sat and unsat results are cached. Since the key is a 64-bit
+/// hash, distinct formula sets may collide with a small probability.
+class CachingSolver : public Solver
+{
+public:
+  typedef uint64_t Hash;
+
+  struct CacheStats
+  {
+    unsigned hits;
+    unsigned disk_hits;
+    unsigned misses;
+  };
+
+private:
+  static constexpr Hash s_fnv_offset = 14695981039346656037ULL;
+  static constexpr Hash s_fnv_prime = 1099511628211ULL;
+
+  typedef std::pair<Hash, CheckResult> Entry;
+  typedef std::list<Entry> Entries;
+  typedef std::unordered_map<Hash, Entries::iterator> EntryMap;
+
+  Solver& m_solver;
+  CacheStats m_cache_stats;
+
+  // structural hash of the most recently encoded term
+  Hash m_hash;
+
+  // memoize hashes of shared subterms while adding a formula
+  std::unordered_map<uintptr_t, Hash> m_hash_map;
+
+  // hashes of asserted formulas, see also push() and pop()
+  std::vector<Hash> m_hashes;
+  std::stack<size_t> m_scopes;
+
+  // most recently used entry is at the front
+  const size_t m_capacity;
+  Entries m_entries;
+  EntryMap m_entry_map;
+
+  // empty if there is no on-disk cache
+  const std::string m_path;
+
+  // all entries of the on-disk cache, see load()
+  std::unordered_map<Hash, CheckResult> m_disk_entries;
+
+  // FNV-1a, independent of the standard library's std::hash
+  static Hash mix(Hash hash, uint64_t value)
+  {
+    for (unsigned i = 0; i < sizeof(value); i++) {
+      hash ^= (value >> (8 * i)) & 0xff;
+      hash *= s_fnv_prime;
+    }
+    return hash;
+  }
+
+  static Hash mix(Hash hash, const std::string& str)
+  {
+    for (const char c : str) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= s_fnv_prime;
+    }
+    return mix(hash, str.size());
+  }
+
+  // same as mixing decl.symbol(), but without formatting keyed symbols
+  static Hash mix(Hash hash, const UnsafeDecl& decl)
+  {
+    if (decl.is_symbol_formatted()) {
+      return mix(hash, decl.symbol());
+    }
+
+    size_t size = 0;
+    for (const char* c = decl.prefix(); *c != '\0'; c++, size++) {
+      hash ^= static_cast<unsigned char>(*c);
+      hash *= s_fnv_prime;
+    }
+
+    // decimal digits of the identifier, most significant first
+    char digits[20];
+    size_t digits_size = 0;
+    uint64_t id = decl.id();
+    do {
+      digits[digits_size++] = '0' + id % 10;
+      id /= 10;
+    } while (id != 0);
+
+    while (digits_size != 0) {
+      hash ^= static_cast<unsigned char>(digits[--digits_size]);
+      hash *= s_fnv_prime;
+      size++;
+    }
+    return mix(hash, size);
+  }
+
+  static Hash mix(Hash hash, const Sort& sort)
+  {
+    hash = mix(hash,
+      sort.is_bool()         |
+      sort.is_int()    << 1  |
+      sort.is_real()   << 2  |
+      sort.is_bv()     << 3  |
+      sort.is_signed() << 4  |
+      sort.is_array()  << 5  |
+      sort.is_func()   << 6);
+    hash = mix(hash, sort.bv_size());
+
+    for (size_t i = 0; i < sort.sorts_size(); i++) {
+      hash = mix(hash, sort.sorts(i));
+    }
+    return mix(hash, sort.sorts_size());
+  }
+
+  // Sets m_hash to the structural hash of the given term
+  Error hash_term(const UnsafeTerm& term)
+  {
+    const uintptr_t addr = term.addr();
+    const std::unordered_map<uintptr_t, Hash>::const_iterator iter(
+      m_hash_map.find(addr));
+    if (iter != m_hash_map.cend()) {
+      m_hash = iter->second;
+      return OK;
+    }
+
+    const Error err = term.encode(*this);
+    if (err) {
+      return err;
+    }
+    m_hash_map.emplace(addr, m_hash);
+    return OK;
+  }
+
+  template<typename T>
+  Error hash_literal(const Sort& sort, T literal)
+  {
+    Hash hash = mix(s_fnv_offset, LITERAL_EXPR_KIND);
+    hash = mix(hash, sort);
+    m_hash = mix(hash, static_cast<uint64_t>(literal));
+    return OK;
+  }
+
+#define SMT_CACHE_ENCODE_BUILTIN_LITERAL(type)    \
+  virtual Error __encode_literal(                 \
+     const Sort& sort,                            \
+     type literal) override                       \
+  {                                               \
+    return hash_literal(sort, literal);           \
+  }                                               \
+
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(bool)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(char)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(signed char)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(unsigned char)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(wchar_t)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(char16_t)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(char32_t)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(short)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(unsigned short)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(int)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(unsigned int)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(long)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(unsigned long)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(long long)
+SMT_CACHE_ENCODE_BUILTIN_LITERAL(unsigned long long)
+
+  virtual Error __encode_constant(
+    const UnsafeDecl& decl) override
+  {
+    Hash hash = mix(s_fnv_offset, CONSTANT_EXPR_KIND);
+    hash = mix(hash, decl.sort());
+    m_hash = mix(hash, decl);
+    return OK;
+  }
+
+  virtual Error __encode_func_app(
+    const UnsafeDecl& func_decl,
+    const size_t arity,
+    const UnsafeTerm* const args) override
+  {
+    Hash hash = mix(s_fnv_offset, FUNC_APP_EXPR_KIND);
+    hash = mix(hash, func_decl.sort());
+    hash = mix(hash, func_decl);
+
+    Error err;
+    for (size_t i = 0; i < arity; i++) {
+      err = hash_term(args[i]);
+      if (err) {
+        return err;
+      }
+      hash = mix(hash, m_hash);
+    }
+    m_hash = hash;
+    return OK;
+  }
+
+  virtual Error __encode_const_array(
+    const Sort& sort,
+    const UnsafeTerm& init) override
+  {
+    const Error err = hash_term(init);
+    if (err) {
+      return err;
+    }
+
+    Hash hash = mix(s_fnv_offset, CONST_ARRAY_EXPR_KIND);
+    hash = mix(hash, sort);
+    m_hash = mix(hash, m_hash);
+    return OK;
+  }
+
+  virtual Error __encode_array_select(
+    const UnsafeTerm& array,
+    const UnsafeTerm& index) override
+  {
+    Error err;
+    Hash hash = mix(s_fnv_offset, ARRAY_SELECT_EXPR_KIND);
+
+    err = hash_term(array);
+    if (err) {
+      return err;
+    }
+    hash = mix(hash, m_hash);
+
+    err = hash_term(index);
+    if (err) {
+      return err;
+    }
+    m_hash = mix(hash, m_hash);
+    return OK;
+  }
+
+  virtual Error __encode_array_store(
+    const UnsafeTerm& array,
+    const UnsafeTerm& index,
+    const UnsafeTerm& value) override
+  {
+    Error err;
+    Hash hash = mix(s_fnv_offset, ARRAY_STORE_EXPR_KIND);
+
+    err = hash_term(array);
+    if (err) {
+      return err;
+    }
+    hash = mix(hash, m_hash);
+
+    err = hash_term(index);
+    if (err) {
+      return err;
+    }
+    hash = mix(hash, m_hash);
+
+    err = hash_term(value);
+    if (err) {
+      return err;
+    }
+    m_hash = mix(hash, m_hash);
+    return OK;
+  }
+
+  virtual Error __encode_unary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerm& arg) override
+  {
+    const Error err = hash_term(arg);
+    if (err) {
+      return err;
+    }
+
+    Hash hash = mix(s_fnv_offset, UNARY_EXPR_KIND);
+    hash = mix(hash, opcode);
+    hash = mix(hash, sort);
+    m_hash = mix(hash, m_hash);
+    return OK;
+  }
+
+  virtual Error __encode_binary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerm& larg,
+    const UnsafeTerm& rarg) override
+  {
+    Error err;
+    Hash hash = mix(s_fnv_offset, BINARY_EXPR_KIND);
+    hash = mix(hash, opcode);
+    hash = mix(hash, sort);
+
+    err = hash_term(larg);
+    if (err) {
+      return err;
+    }
+    hash = mix(hash, m_hash);
+
+    err = hash_term(rarg);
+    if (err) {
+      return err;
+    }
+    m_hash = mix(hash, m_hash);
+    return OK;
+  }
+
+  virtual Error __encode_nary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerms& args) override
+  {
+    Error err;
+    Hash hash = mix(s_fnv_offset, NARY_EXPR_KIND);
+    hash = mix(hash, opcode);
+    hash = mix(hash, sort);
+
+    for (const UnsafeTerm& arg : args) {
+      err = hash_term(arg);
+      if (err) {
+        return err;
+      }
+      hash = mix(hash, m_hash);
+    }
+    m_hash = mix(hash, args.size());
+    return OK;
+  }
+
+  // Order-independent hash of all formulas in all open scopes
+  Hash key() const
+  {
+    std::vector<Hash> hashes(m_hashes);
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    Hash hash = s_fnv_offset;
+    for (const Hash h : hashes) {
+      hash = mix(hash, h);
+    }
+    return mix(hash, hashes.size());
+  }
+
+  void insert(Hash key, CheckResult result)
+  {
+    if (m_capacity == 0) {
+      return;
+    }
+
+    if (m_entries.size() == m_capacity) {
+      m_entry_map.erase(m_entries.back().first);
+      m_entries.pop_back();
+    }
+    m_entries.emplace_front(key, result);
+    m_entry_map[key] = m_entries.begin();
+  }
+
+  bool lookup(Hash key, CheckResult& result)
+  {
+    const EntryMap::iterator iter(m_entry_map.find(key));
+    if (iter == m_entry_map.end()) {
+      return false;
+    }
+
+    // move to front
+    m_entries.splice(m_entries.begin(), m_entries, iter->second);
+    result = iter->second->second;
+    return true;
+  }
+
+  // On-disk cache is a text file with one "key result" pair per line
+  void load()
+  {
+    if (m_path.empty()) {
+      return;
+    }
+
+    std::ifstream file(m_path);
+    Hash disk_key;
+    unsigned disk_result;
+    while (file >> std::hex >> disk_key >> std::dec >> disk_result) {
+      if (disk_result <= unknown) {
+        m_disk_entries.emplace(disk_key,
+          static_cast<CheckResult>(disk_result));
+      }
+    }
+  }
+
+  bool disk_lookup(Hash key, CheckResult& result) const
+  {
+    const std::unordered_map<Hash, CheckResult>::const_iterator iter(
+      m_disk_entries.find(key));
+    if (iter == m_disk_entries.cend()) {
+      return false;
+    }
+
+    result = iter->second;
+    return true;
+  }
+
+  void disk_insert(Hash key, CheckResult result)
+  {
+    if (m_path.empty()) {
+      return;
+    }
+
+    m_disk_entries.emplace(key, result);
+    std::ofstream file(m_path, std::ios::app);
+    file << std::hex << key << ' ' << std::dec << result << '\n';
+  }
+
+  virtual void __reset() override
+  {
+    m_hashes.clear();
+    while (!m_scopes.empty()) {
+      m_scopes.pop();
+    }
+    m_solver.reset();
+  }
+
+  virtual void __push() override
+  {
+    m_scopes.push(m_hashes.size());
+    m_solver.push();
+  }
+
+  virtual void __pop() override
+  {
+    assert(!m_scopes.empty());
+    m_hashes.resize(m_scopes.top());
+    m_scopes.pop();
+    m_solver.pop();
+  }
+
+  virtual Error __unsafe_add(const UnsafeTerm& condition) override
+  {
+    const Error err = hash_term(condition);
+    m_hash_map.clear();
+    if (err) {
+      return err;
+    }
+    m_hashes.push_back(m_hash);
+    m_solver.unsafe_add(condition);
+    return OK;
+  }
+
+  virtual Error __add(const Bool& condition) override
+  {
+    return __unsafe_add(condition);
+  }
+
+  virtual void __interrupt() override
+  {
+    m_solver.interrupt();
+  }
+
+  virtual CheckResult __check() override
+  {
+    const Hash k = key();
+
+    CheckResult result;
+    if (lookup(k, result)) {
+      m_cache_stats.hits++;
+      return result;
+    }
+
+    if (disk_lookup(k, result)) {
+      m_cache_stats.disk_hits++;
+      insert(k, result);
+      return result;
+    }
+
+    m_cache_stats.misses++;
+    result = m_solver.check();
+    if (result != unknown) {
+      insert(k, result);
+      disk_insert(k, result);
+    }
+    return result;
+  }
+
+public:
+  /// Forward all formulas to the given solver
+
+  /// \param capacity maximum number of in-memory cache entries
+  /// \param path optional file name of the on-disk cache
+  CachingSolver(
+    Solver& solver,
+    size_t capacity = 1024,
+    const std::string& path = "")
+  : m_solver(solver),
+    m_cache_stats{0},
+    m_hash(s_fnv_offset),
+    m_hash_map(),
+    m_hashes(),
+    m_scopes(),
+    m_capacity(capacity),
+    m_entries(),
+    m_entry_map(),
+    m_path(path),
+    m_disk_entries()
+  {
+    load();
+  }
+
+  const CacheStats& cache_stats() const
+  {
+    return m_cache_stats;
+  }
+
+  /// Order-independent structural hash of all asserted formulas
+  Hash hash() const
+  {
+    return key();
+  }
+};
+
+}
+
+#endif
@@ -17,6 +17,7 @@
 #include <cvc4/expr/expr_manager.h>
 #include <cvc4/smt/smt_engine.h>
 
+#include <stack>
 #include <unordered_map>
 
 namespace smt
@@ -36,6 +37,15 @@ private:
   typedef std::unordered_map<std::string, const CVC4::Expr> ExprMap;
   ExprMap m_expr_map;
 
+  // see enable_models()
+  bool m_is_model_producing;
+
+  // Assertion log for clone(), only kept if m_is_cloneable,
+  // see also push() and pop()
+  bool m_is_cloneable;
+  UnsafeTerms m_terms;
+  std::stack<size_t> m_scopes;
+
   void set_expr(const CVC4::Expr& expr)
   {
     m_expr = expr;
@@ -506,11 +516,15 @@ SMT_CVC4_STRING_ENCODE_LITERAL(unsigned long long)
 
   virtual void __push() override
   {
+    m_scopes.push(m_terms.size());
     m_smt_engine.push();
   }
 
   virtual void __pop() override
   {
+    assert(!m_scopes.empty());
+    m_terms.resize(m_scopes.top());
+    m_scopes.pop();
     m_smt_engine.pop();
   }
 
@@ -522,6 +536,9 @@ SMT_CVC4_STRING_ENCODE_LITERAL(unsigned long long)
     }
     // unclear how to use assertFormula()'s return value
     m_smt_engine.assertFormula(m_expr);
+    if (m_is_cloneable) {
+      m_terms.push_back(condition);
+    }
     return OK;
   }
 
@@ -542,13 +559,89 @@ SMT_CVC4_STRING_ENCODE_LITERAL(unsigned long long)
     }
   }
 
+  // Trips CVC4's resource manager, so checkSat() gives up
+  virtual void __interrupt() override
+  {
+    m_smt_engine.interrupt();
+  }
+
+  // Options cannot be changed once CVC4 has been initialized
+  virtual Error __enable_models() override
+  {
+    if (m_is_model_producing) {
+      return OK;
+    }
+
+    try {
+      m_smt_engine.setOption("produce-models", true);
+    } catch (const CVC4::ModalException&) {
+      return UNSUPPORT_ERROR;
+    }
+    m_is_model_producing = true;
+    return OK;
+  }
+
+  virtual Error __get_value(
+    const UnsafeTerm& term,
+    long long& value) override
+  {
+    if (!m_is_model_producing) {
+      return UNSUPPORT_ERROR;
+    }
+
+    const Error err = term.encode(*this);
+    if (err) {
+      return err;
+    }
+
+    const CVC4::Expr cvc4_value(m_smt_engine.getValue(m_expr));
+    if (cvc4_value.getType().isBitVector()) {
+      // CVC4 bit-vector constants are unsigned
+      value = bv_value(term.sort(), cvc4_value.getConst<CVC4::BitVector>().
+        toInteger().getUnsignedLong());
+    } else {
+      const CVC4::Rational& rational = cvc4_value.getConst<CVC4::Rational>();
+      if (!rational.isIntegral()) {
+        return UNSUPPORT_ERROR;
+      }
+      value = rational.getNumerator().getLong();
+    }
+    return OK;
+  }
+
+  // CVC4 expressions cannot be shared across expression managers,
+  // so the clone re-encodes all recorded assertions
+  virtual Solver* __clone() override
+  {
+    if (!m_is_cloneable) {
+      return nullptr;
+    }
+
+    CVC4Solver* solver = new CVC4Solver(m_expr_manager.getOptions());
+    solver->m_smt_engine.setLogic(m_smt_engine.getLogicInfo());
+    solver->set_cloneable(true);
+    if (m_is_model_producing) {
+      const Error err = solver->enable_models();
+      assert(err == OK);
+    }
+
+    for (const UnsafeTerm& term : m_terms) {
+      solver->unsafe_add(term);
+    }
+    return solver;
+  }
+
 public:
   /// Auto configure CVC4
   CVC4Solver()
   : m_expr_manager(),
     m_smt_engine(&m_expr_manager),
     m_expr(),
-    m_expr_map()
+    m_expr_map(),
+    m_is_model_producing(false),
+    m_is_cloneable(false),
+    m_terms(),
+    m_scopes()
   {
     m_smt_engine.setOption("incremental", true);
     m_smt_engine.setOption("output-language", "smt2");
@@ -558,7 +651,11 @@ public:
   : m_expr_manager(options),
     m_smt_engine(&m_expr_manager),
     m_expr(),
-    m_expr_map()
+    m_expr_map(),
+    m_is_model_producing(false),
+    m_is_cloneable(false),
+    m_terms(),
+    m_scopes()
   {
     m_smt_engine.setOption("incremental", true);
   }
@@ -567,13 +664,34 @@ public:
   : m_expr_manager(),
     m_smt_engine(&m_expr_manager),
     m_expr(),
-    m_expr_map()
+    m_expr_map(),
+    m_is_model_producing(false),
+    m_is_cloneable(false),
+    m_terms(),
+    m_scopes()
   {
     m_smt_engine.setOption("incremental", true);
     m_smt_engine.setOption("output-language", "smt2");
     m_smt_engine.setLogic(Logics::acronyms[logic]);
   }
 
+  /// Record assertions so that clone() can replay them
+
+  /// The record grows with the assertions in all open scopes, so
+  /// clone() returns null unless it has been enabled.
+  ///
+  /// \pre: no formulas have been added
+  void set_cloneable(bool is_cloneable)
+  {
+    assert(m_terms.empty());
+    m_is_cloneable = is_cloneable;
+  }
+
+  bool is_cloneable() const
+  {
+    return m_is_cloneable;
+  }
+
   CVC4::ExprManager& expr_manager()
   {
     return m_expr_manager;
@@ -6,6 +6,7 @@
 #define __SMT_MSAT_H_
 
 #include <limits>
+#include <cstdlib>
 #include <cinttypes>
 #include <mathsat.h>
 
@@ -17,10 +18,15 @@ namespace smt
 class MsatSolver : public Solver
 {
 private:
+  // null if MathSAT5 is auto configured
+  const char* const m_logic_acronym;
   msat_config m_config;
   msat_env m_env;
   msat_term m_term;
 
+  // see enable_models()
+  bool m_is_model_generation;
+
   void set_term(msat_term term)
   {
     m_term = term;
@@ -533,30 +539,134 @@ SMT_MSAT_CAST_ENCODE_BUILTIN_LITERAL(unsigned long long)
     }
   }
 
-public:
-  /// Auto configure MathSAT5
-  MsatSolver()
-  : m_config(msat_create_config()),
-    m_env(msat_create_env(m_config)),
-    m_term()
+  // MathSAT5 polls this callback during msat_solve()
+  static int termination_test(void* user_data)
   {
-    assert(!MSAT_ERROR_CONFIG(m_config));
+    return static_cast<const MsatSolver*>(user_data)->is_interrupted();
+  }
+
+  // model_generation is a configuration option, so the environment
+  // is created again, which requires that it has no formulas yet
+  virtual Error __enable_models() override
+  {
+    if (m_is_model_generation) {
+      return OK;
+    }
+
+    size_t terms_size = 0;
+    msat_term* const terms = msat_get_asserted_formulas(m_env, &terms_size);
+    if (terms != nullptr) {
+      msat_free(terms);
+    }
+    if (0 < terms_size || 0 < msat_num_backtrack_points(m_env)) {
+      return UNSUPPORT_ERROR;
+    }
+
+    int status = msat_set_option(m_config, "model_generation", "true");
+    assert(status == 0);
+
+    msat_destroy_env(m_env);
+    m_env = msat_create_env(m_config);
     assert(!MSAT_ERROR_ENV(m_env));
 
-    MSAT_MAKE_ERROR_TERM(m_term);
+    status = msat_set_termination_test(m_env,
+      &MsatSolver::termination_test, this);
+    assert(status == 0);
+
+    m_is_model_generation = true;
+    return OK;
   }
 
-  MsatSolver(Logic logic)
-  : m_config(msat_create_default_config(Logics::acronyms[logic])),
+  virtual Error __get_value(
+    const UnsafeTerm& term,
+    long long& value) override
+  {
+    if (!m_is_model_generation) {
+      return UNSUPPORT_ERROR;
+    }
+
+    const Error err = term.encode(*this);
+    if (err) {
+      return err;
+    }
+
+    const msat_term msat_value = msat_get_model_value(m_env, m_term);
+    if (MSAT_ERROR_TERM(msat_value) ||
+        !msat_term_is_number(m_env, msat_value)) {
+      return UNSUPPORT_ERROR;
+    }
+
+    // e.g. "-7" for integers, "7_16" for bit-vectors of size 16,
+    // where the latter are always written as unsigned numbers
+    const Sort& sort = term.sort();
+    char* const repr = msat_term_repr(msat_value);
+    char* end;
+    if (sort.is_bv()) {
+      value = bv_value(sort, std::strtoull(repr, &end, 10));
+    } else {
+      value = std::strtoll(repr, &end, 10);
+    }
+    const bool is_number = end != repr;
+    msat_free(repr);
+    return is_number ? OK : UNSUPPORT_ERROR;
+  }
+
+  static msat_config make_config(const char* const logic_acronym)
+  {
+    msat_config config(logic_acronym == nullptr ? msat_create_config() :
+      msat_create_default_config(logic_acronym));
+    assert(!MSAT_ERROR_CONFIG(config));
+    return config;
+  }
+
+  // Copy asserted formulas into a new environment
+  virtual Solver* __clone() override
+  {
+    MsatSolver* solver = new MsatSolver(m_logic_acronym);
+    if (m_is_model_generation) {
+      const Error err = solver->enable_models();
+      assert(err == OK);
+    }
+
+    size_t terms_size;
+    msat_term* const terms = msat_get_asserted_formulas(m_env, &terms_size);
+    assert(terms != nullptr);
+    for (size_t i = 0; i < terms_size; i++) {
+      solver->set_term(msat_make_copy_from(solver->m_env, terms[i], m_env));
+      const int status = msat_assert_formula(solver->m_env, solver->m_term);
+      assert(status == 0);
+    }
+    msat_free(terms);
+
+    return solver;
+  }
+
+  MsatSolver(const char* const logic_acronym)
+  : m_logic_acronym(logic_acronym),
+    m_config(make_config(logic_acronym)),
     m_env(msat_create_env(m_config)),
-    m_term()
+    m_term(),
+    m_is_model_generation(false)
   {
     assert(!MSAT_ERROR_CONFIG(m_config));
     assert(!MSAT_ERROR_ENV(m_env));
 
     MSAT_MAKE_ERROR_TERM(m_term);
+
+    const int status = msat_set_termination_test(m_env,
+      &MsatSolver::termination_test, this);
+    assert(status == 0);
   }
 
+public:
+  /// Auto configure MathSAT5
+  MsatSolver()
+  : MsatSolver(nullptr) {}
+
+  /// MathSAT5 is auto configured for ALL_LOGIC
+  MsatSolver(Logic logic)
+  : MsatSolver(logic == ALL_LOGIC ? nullptr : Logics::acronyms[logic]) {}
+
   ~MsatSolver()
   {
     msat_destroy_config(m_config);
@@ -0,0 +1,482 @@
+// Copyright 2014, Alex Horn. All rights reserved.
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file.
+
+#ifndef __SMT_PARTITION_H_
+#define __SMT_PARTITION_H_
+
+#include <map>
+#include <stack>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
+
+#include "smt.h"
+
+namespace smt
+{
+
+/// Check independent subsets of formulas separately
+
+/// Two asserted formulas are dependent if they share a free constant
+/// or function symbol. At check(), formulas are partitioned into the
+/// connected components of this relation (using union-find) and each
+/// component is checked in its own push() / pop() scope of the wrapped
+/// solver. The conjunction of all formulas is unsat if and only if some
+/// component is unsat. Components are checked one after another because
+/// they share the wrapped solver. The result of a component whose
+/// formulas have not changed since the previous check() is reused
+/// without consulting the wrapped solver. If the wrapped solver is a
+/// CachingSolver, then the result of each component is also cached
+/// across pop().
+///
+/// Alternatively, check_goal() slices away all formulas that do not
+/// transitively share any symbols with a given goal formula.
+class PartitionSolver : public Solver
+{
+public:
+  struct PartitionStats
+  {
+    unsigned checks;
+    unsigned components;
+    unsigned reused_components;
+    unsigned sliced_terms;
+    unsigned sliced_nodes;
+  };
+
+private:
+  typedef size_t SymbolIdentifier;
+  typedef std::vector<SymbolIdentifier> SymbolIdentifiers;
+
+  Solver& m_solver;
+  PartitionStats m_partition_stats;
+
+  typedef std::unordered_map<std::string, SymbolIdentifier>
+    SymbolIdentifierMap;
+
+  struct Scope
+  {
+    size_t terms_size;
+    size_t symbols_size;
+  };
+
+  // symbols of the formula that is currently being added
+  SymbolIdentifiers m_symbol_ids;
+  std::unordered_set<uintptr_t> m_visited;
+  SymbolIdentifierMap m_symbol_id_map;
+
+  // indexed by symbol identifier, points to the keys of m_symbol_id_map
+  std::vector<const std::string*> m_symbols;
+
+  // asserted formulas and their symbols, see also push() and pop()
+  UnsafeTerms m_terms;
+  std::vector<SymbolIdentifiers> m_terms_symbol_ids;
+  std::vector<size_t> m_terms_nodes;
+  std::stack<Scope> m_scopes;
+
+  // sat or unsat results of the components at the previous check(),
+  // keyed by the ascending indices of their formulas in m_terms
+  typedef std::vector<size_t> ComponentKey;
+  std::map<ComponentKey, CheckResult> m_component_results;
+
+  Error visit(const UnsafeTerm& term)
+  {
+    if (!m_visited.insert(term.addr()).second) {
+      return OK;
+    }
+    return term.encode(*this);
+  }
+
+  void visit_symbol(const std::string& symbol)
+  {
+    const SymbolIdentifier id(m_symbol_id_map.size());
+    const std::pair<SymbolIdentifierMap::iterator, bool> pair(
+      m_symbol_id_map.emplace(symbol, id));
+    if (pair.second) {
+      m_symbols.push_back(&pair.first->first);
+    }
+    m_symbol_ids.push_back(pair.first->second);
+  }
+
+#define SMT_PARTITION_ENCODE_BUILTIN_LITERAL(type) \
+  virtual Error __encode_literal(                  \
+     const Sort& sort,                             \
+     type literal) override                        \
+  {                                                \
+    return OK;                                     \
+  }                                                \
+
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(bool)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(char)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(signed char)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(unsigned char)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(wchar_t)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(char16_t)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(char32_t)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(short)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(unsigned short)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(int)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(unsigned int)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(long)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(unsigned long)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(long long)
+SMT_PARTITION_ENCODE_BUILTIN_LITERAL(unsigned long long)
+
+  virtual Error __encode_constant(
+    const UnsafeDecl& decl) override
+  {
+    visit_symbol(decl.symbol());
+    return OK;
+  }
+
+  virtual Error __encode_func_app(
+    const UnsafeDecl& func_decl,
+    const size_t arity,
+    const UnsafeTerm* const args) override
+  {
+    visit_symbol(func_decl.symbol());
+
+    Error err;
+    for (size_t i = 0; i < arity; i++) {
+      err = visit(args[i]);
+      if (err) {
+        return err;
+      }
+    }
+    return OK;
+  }
+
+  virtual Error __encode_const_array(
+    const Sort& sort,
+    const UnsafeTerm& init) override
+  {
+    return visit(init);
+  }
+
+  virtual Error __encode_array_select(
+    const UnsafeTerm& array,
+    const UnsafeTerm& index) override
+  {
+    const Error err = visit(array);
+    if (err) {
+      return err;
+    }
+    return visit(index);
+  }
+
+  virtual Error __encode_array_store(
+    const UnsafeTerm& array,
+    const UnsafeTerm& index,
+    const UnsafeTerm& value) override
+  {
+    Error err;
+    err = visit(array);
+    if (err) {
+      return err;
+    }
+    err = visit(index);
+    if (err) {
+      return err;
+    }
+    return visit(value);
+  }
+
+  virtual Error __encode_unary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerm& arg) override
+  {
+    return visit(arg);
+  }
+
+  virtual Error __encode_binary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerm& larg,
+    const UnsafeTerm& rarg) override
+  {
+    const Error err = visit(larg);
+    if (err) {
+      return err;
+    }
+    return visit(rarg);
+  }
+
+  virtual Error __encode_nary(
+    Opcode opcode,
+    const Sort& sort,
+    const UnsafeTerms& args) override
+  {
+    Error err;
+    for (const UnsafeTerm& arg : args) {
+      err = visit(arg);
+      if (err) {
+        return err;
+      }
+    }
+    return OK;
+  }
+
+  static size_t find(std::vector<size_t>& parents, size_t i)
+  {
+    while (parents[i] != i) {
+      // path halving
+      parents[i] = parents[parents[i]];
+      i = parents[i];
+    }
+    return i;
+  }
+
+  /// Returns the component index of every asserted formula
+  std::vector<size_t> partition(size_t& components_size) const
+  {
+    const size_t terms_size = m_terms.size();
+
+    // union-find over formula indices
+    std::vector<size_t> parents(terms_size);
+    for (size_t i = 0; i < terms_size; i++) {
+      parents[i] = i;
+    }
+
+    // first formula in which a symbol occurs
+    const size_t none = terms_size;
+    std::vector<size_t> owners(m_symbol_id_map.size(), none);
+    for (size_t i = 0; i < terms_size; i++) {
+      for (const SymbolIdentifier id : m_terms_symbol_ids[i]) {
+        if (owners[id] == none) {
+          owners[id] = i;
+        } else {
+          parents[find(parents, i)] = find(parents, owners[id]);
+        }
+      }
+    }
+
+    // number components consecutively
+    std::vector<size_t> components(terms_size, none);
+    components_size = 0;
+    for (size_t i = 0; i < terms_size; i++) {
+      const size_t root = find(parents, i);
+      if (components[root] == none) {
+        components[root] = components_size++;
+      }
+      components[i] = components[root];
+    }
+    return components;
+  }
+
+  virtual void __reset() override
+  {
+    m_terms.clear();
+    m_terms_symbol_ids.clear();
+    m_terms_nodes.clear();
+    m_symbol_id_map.clear();
+    m_symbols.clear();
+    m_component_results.clear();
+    while (!m_scopes.empty()) {
+      m_scopes.pop();
+    }
+    m_solver.reset();
+  }
+
+  virtual void __push() override
+  {
+    m_scopes.push(Scope{m_terms.size(), m_symbols.size()});
+  }
+
+  // Symbols first seen in the popped scope only occur in its formulas
+  virtual void __pop() override
+  {
+    assert(!m_scopes.empty());
+    const Scope& scope = m_scopes.top();
+    m_terms.resize(scope.terms_size);
+    m_terms_symbol_ids.resize(scope.terms_size);
+    m_terms_nodes.resize(scope.terms_size);
+
+    for (size_t id = scope.symbols_size; id < m_symbols.size(); id++) {
+      m_symbol_id_map.erase(m_symbol_id_map.find(*m_symbols[id]));
+    }
+    m_symbols.resize(scope.symbols_size);
+
+    // indices of popped formulas may be reused by later formulas
+    std::map<ComponentKey, CheckResult>::iterator iter(
+      m_component_results.begin());
+    while (iter != m_component_results.end()) {
+      if (iter->first.back() < scope.terms_size) {
+        ++iter;
+      } else {
+        iter = m_component_results.erase(iter);
+      }
+    }
+    m_scopes.pop();
+  }
+
+  virtual Error __unsafe_add(const UnsafeTerm& condition) override
+  {
+    const Error err = visit(condition);
+    const size_t nodes = m_visited.size();
+    m_visited.clear();
+    if (err) {
+      m_symbol_ids.clear();
+      return err;
+    }
+
+    std::sort(m_symbol_ids.begin(), m_symbol_ids.end());
+    m_symbol_ids.erase(std::unique(m_symbol_ids.begin(),
+      m_symbol_ids.end()), m_symbol_ids.end());
+
+    m_terms.push_back(condition);
+    m_terms_symbol_ids.push_back(std::move(m_symbol_ids));
+    m_terms_nodes.push_back(nodes);
+    m_symbol_ids.clear();
+    return OK;
+  }
+
+  virtual Error __add(const Bool& condition) override
+  {
+    return __unsafe_add(condition);
+  }
+
+  virtual void __interrupt() override
+  {
+    m_solver.interrupt();
+  }
+
+  virtual CheckResult __check() override
+  {
+    m_partition_stats.checks++;
+    if (m_terms.empty()) {
+      return m_solver.check();
+    }
+
+    size_t components_size;
+    const std::vector<size_t> components(partition(components_size));
+    m_partition_stats.components += components_size;
+
+    std::vector<ComponentKey> component_keys(components_size);
+    for (size_t i = 0; i < m_terms.size(); i++) {
+      component_keys[components[i]].push_back(i);
+    }
+
+    // forget components that have been merged into larger ones
+    std::map<ComponentKey, CheckResult> component_results;
+    for (const ComponentKey& key : component_keys) {
+      const std::map<ComponentKey, CheckResult>::const_iterator
+        iter(m_component_results.find(key));
+      if (iter != m_component_results.cend()) {
+        component_results.insert(*iter);
+      }
+    }
+    std::swap(component_results, m_component_results);
+
+    CheckResult result = sat;
+    for (ComponentKey& key : component_keys) {
+      CheckResult component_result;
+      const std::map<ComponentKey, CheckResult>::const_iterator
+        iter(m_component_results.find(key));
+      if (iter == m_component_results.cend()) {
+        if (is_interrupted()) {
+          return unknown;
+        }
+
+        m_solver.push();
+        for (const size_t i : key) {
+          m_solver.unsafe_add(m_terms[i]);
+        }
+        component_result = m_solver.check();
+        m_solver.pop();
+
+        if (component_result != unknown) {
+          m_component_results.emplace(std::move(key), component_result);
+        }
+      } else {
+        m_partition_stats.reused_components++;
+        component_result = iter->second;
+      }
+
+      if (component_result == unsat) {
+        return unsat;
+      }
+      if (component_result == unknown) {
+        result = unknown;
+      }
+    }
+    return result;
+  }
+
+public:
+  /// Forward formulas to the given solver only at check()
+  PartitionSolver(Solver& solver)
+  : m_solver(solver),
+    m_partition_stats{0},
+    m_symbol_ids(),
+    m_visited(),
+    m_symbol_id_map(),
+    m_symbols(),
+    m_terms(),
+    m_terms_symbol_ids(),
+    m_terms_nodes(),
+    m_scopes(),
+    m_component_results() {}
+
+  const PartitionStats& partition_stats() const
+  {
+    return m_partition_stats;
+  }
+
+  /// Number of distinct symbols in the asserted formulas
+  size_t symbols_size() const
+  {
+    return m_symbols.size();
+  }
+
+  /// Check goal together with its cone of influence
+
+  /// Only those formulas are given to the wrapped solver that share
+  /// symbols with the goal, either directly or through other formulas.
+  /// The result is only meaningful if the remaining formulas are
+  /// satisfiable on their own, as is the case with encodings whose
+  /// constraints can always be satisfied (e.g. partial orders).
+  CheckResult check_goal(const UnsafeTerm& goal)
+  {
+    assert(goal.sort().is_bool());
+
+    m_partition_stats.checks++;
+    clear_interrupt();
+
+    // goal is temporarily the last formula
+    push();
+    unsafe_add(goal);
+
+    size_t components_size;
+    const std::vector<size_t> components(partition(components_size));
+    const size_t goal_index = m_terms.size() - 1;
+    const size_t goal_component = components[goal_index];
+
+    m_solver.push();
+    for (size_t i = 0; i < m_terms.size(); i++) {
+      if (is_interrupted()) {
+        m_solver.pop();
+        pop();
+        return unknown;
+      }
+
+      if (components[i] == goal_component) {
+        m_solver.unsafe_add(m_terms[i]);
+      } else {
+        m_partition_stats.sliced_terms++;
+        m_partition_stats.sliced_nodes += m_terms_nodes[i];
+      }
+    }
+    const CheckResult result = m_solver.check();
+    m_solver.pop();
+
+    pop();
+    return result;
+  }
+};
+
+}
+
+#endif
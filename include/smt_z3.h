@@ -16,6 +16,8 @@ namespace smt
 class Z3Solver : public Solver
 {
 private:
+  // null if Z3 is auto configured
+  const char* const m_logic_acronym;
   z3::context m_z3_context;
   z3::solver m_z3_solver;
   z3::expr m_z3_expr;
@@ -470,17 +472,99 @@ SMT_Z3_CAST_ENCODE_BUILTIN_LITERAL(unsigned long)
     }
   }
 
+  virtual CheckResult __check_assumption(const Bool& assumption) override
+  {
+    const Error err = UnsafeTerm(assumption).encode(*this);
+    assert(err == OK);
+    if (err) {
+      return unknown;
+    }
+
+    z3::expr_vector assumptions(m_z3_context);
+    assumptions.push_back(expr());
+    switch (m_z3_solver.check(assumptions)) {
+    case z3::unsat:
+      return unsat;
+    case z3::sat:
+      return sat;
+    case z3::unknown:
+      return unknown;
+    }
+    assert(false);
+    return unknown;
+  }
+
+  virtual void __interrupt() override
+  {
+    m_z3_context.interrupt();
+  }
+
+  // Z3 always has a model after a sat check()
+  virtual Error __enable_models() override
+  {
+    return OK;
+  }
+
+  virtual Error __get_value(
+    const UnsafeTerm& term,
+    long long& value) override
+  {
+    const Error err = term.encode(*this);
+    if (err) {
+      return err;
+    }
+
+    const z3::expr z3_value(m_z3_solver.get_model().eval(m_z3_expr, true));
+    const Sort& sort = term.sort();
+    if (sort.is_bv()) {
+      // Z3 bit-vector numerals are unsigned
+      uint64_t z3_uint64;
+      if (Z3_get_numeral_uint64(m_z3_context, z3_value, &z3_uint64)) {
+        value = bv_value(sort, z3_uint64);
+        return OK;
+      }
+      return UNSUPPORT_ERROR;
+    }
+
+    int64_t z3_int64;
+    if (Z3_get_numeral_int64(m_z3_context, z3_value, &z3_int64)) {
+      value = z3_int64;
+      return OK;
+    }
+
+    // e.g. the numeral does not fit into 64 bits
+    return UNSUPPORT_ERROR;
+  }
+
+  // Z3_solver_translate() requires the solver to be at its base level,
+  // so instead each asserted formula is translated individually
+  virtual Solver* __clone() override
+  {
+    Z3Solver* solver = new Z3Solver(m_logic_acronym);
+    z3::context& z3_context = solver->m_z3_context;
+
+    const z3::expr_vector z3_assertions(m_z3_solver.assertions());
+    for (unsigned i = 0; i < z3_assertions.size(); i++) {
+      solver->m_z3_solver.add(z3::to_expr(z3_context,
+        Z3_translate(m_z3_context, z3_assertions[i], z3_context)));
+    }
+    return solver;
+  }
+
+  Z3Solver(const char* const logic_acronym)
+  : m_logic_acronym(logic_acronym),
+    m_z3_context(),
+    m_z3_solver(logic_acronym == nullptr ? z3::solver(m_z3_context) :
+      z3::solver(m_z3_context, logic_acronym)),
+    m_z3_expr(m_z3_context) {}
+
 public:
   /// Auto configure Z3
   Z3Solver()
-  : m_z3_context(),
-    m_z3_solver(m_z3_context),
-    m_z3_expr(m_z3_context) {}
+  : Z3Solver(nullptr) {}
 
   Z3Solver(Logic logic)
-  : m_z3_context(),
-    m_z3_solver(m_z3_context, Logics::acronyms[logic]),
-    m_z3_expr(m_z3_context) {}
+  : Z3Solver(Logics::acronyms[logic]) {}
 
   z3::context& context()
   {
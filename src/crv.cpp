@@ -1,19 +1,42 @@
 #include "crv.h"
 
+#include <sstream>
+#include <unordered_set>
+
 namespace crv
 {
 
 const std::string Tracer::s_value_prefix = "v!";
+const std::string Tracer::s_guard_prefix = "g!";
 const std::string Encoder::s_time_prefix = "t!";
 const std::string Encoder::s_rf_prefix = "rf!";
+const std::string Encoder::s_rf_time_prefix = "rft!";
 const std::string Encoder::s_pf_prefix = "pf!";
 const std::string Encoder::s_ldf_prefix = "ldf!";
+const std::string Encoder::s_match_prefix = "match!";
+const std::string Encoder::s_finalizer_prefix = "finalizer!";
+
+// see internal::set_thread_tracer()
+static thread_local Tracer* t_tracer = nullptr;
 
 Tracer& tracer() {
   static Tracer s_tracer;
+  if (t_tracer != nullptr)
+    return *t_tracer;
+
   return s_tracer;
 }
 
+namespace internal
+{
+  Tracer* set_thread_tracer(Tracer* tracer)
+  {
+    Tracer* const previous = t_tracer;
+    t_tracer = tracer;
+    return previous;
+  }
+}
+
 void Tracer::add_assertion(Internal<bool>&& assertion)
 {
   m_assertions.push_back(std::move(assertion.term));
@@ -24,29 +47,944 @@ void Tracer::add_error(Internal<bool>&& error)
   m_errors.push_back(std::move(error.term));
 }
 
+void Tracer::define_guard(
+  const smt::Bool& literal,
+  const smt::Bool& condition)
+{
+  m_guard_definitions.push_back(GuardDefinition{m_events.size(),
+    literal == (m_guard and condition)});
+
+  // replayed definitions are already in the solver, see flip()
+  if (m_guard_solver != nullptr &&
+      m_guard_scopes < m_guard_definitions.size())
+  {
+    assert(m_guard_scopes + 1 == m_guard_definitions.size());
+    m_guard_solver->push();
+    m_guard_solver->add(m_guard_definitions.back().definition);
+    m_guard_scopes++;
+  }
+}
+
 bool Tracer::append_guard(
   const Internal<bool>& internal,
   bool direction)
 {
+  const smt::Bool literal(smt::any<smt::Bool>(s_guard_prefix.c_str(),
+    m_guard_definitions.size()));
+
+  bool is_defined = false;
   if (m_flip_iter == m_flips.cend())
   {
-    m_flips.push_back(Flip(direction));
+    // is the direction infeasible? If so, the other one is feasible
+    // because the path condition so far is.
+    bool is_flip = false;
+    if (m_guard_solver != nullptr)
+    {
+      define_guard(literal, direction ? internal.term : !internal.term);
+      if (smt::unsat == m_guard_solver->check_assumption(literal))
+      {
+        m_guard_definitions.pop_back();
+        pop_guard_scopes(m_guard_definitions.size());
+
+        direction = !direction;
+        define_guard(literal, direction ? internal.term : !internal.term);
+        is_flip = true;
+        m_prune_cnt++;
+      }
+      is_defined = true;
+    }
+
+    // guards beyond the depth bound are never flipped
+    if (0 < m_depth_bound && m_depth_bound <= m_flips.size())
+      is_flip = true;
+
+    m_flips.push_back(Flip(direction, m_events.size()));
+    m_flips.back().is_flip = is_flip;
     assert(m_flips.back().direction == direction);
   }
   else
   {
     direction = m_flip_iter->direction;
+    if (std::next(m_flip_iter) == m_flips.cend())
+    {
+      // events after the flipped guard must not reuse identifiers
+      m_event_id_cnt = std::max(m_event_id_cnt, m_event_id_max);
+      m_flips.back().event_id_cnt = m_event_id_cnt;
+    }
+
+    // replay identifiers of previous paths
+    m_event_id_cnt = std::max(m_event_id_cnt, m_flip_iter->event_id_cnt);
     m_flip_iter++;
   }
 
-  if (direction)
-    m_guard = m_guard and internal.term;
-  else
-    m_guard = m_guard and !internal.term;
+  if (m_search_strategy == COVERAGE_SEARCH)
+    m_coverage[coverage_key(m_events.size(), direction)]++;
+
+  if (!is_defined)
+    define_guard(literal, direction ? internal.term : !internal.term);
+
+  m_guard = literal;
+  m_is_guard_interned = false;
 
   return direction;
 }
 
+bool Tracer::pop_pending_flips(size_t& flip_index)
+{
+  // every guard along the current path that has not been flipped yet
+  // is the root of an unexplored subtree
+  FlipList prefix;
+  for (Flip& flip : m_flips)
+  {
+    if (!flip.is_flip)
+    {
+      flip.is_flip = true;
+      m_pending_flips.push_back(prefix);
+      m_pending_flips.back().push_back(
+        Flip(!flip.direction, flip.events_size));
+      m_pending_flips.back().back().is_flip = true;
+    }
+    prefix.push_back(flip);
+  }
+
+  if (m_pending_flips.empty())
+    return false;
+
+  size_t i = 0;
+  switch (m_search_strategy)
+  {
+  case BFS_SEARCH:
+    for (size_t j = 1; j < m_pending_flips.size(); j++)
+      if (m_pending_flips[j].size() < m_pending_flips[i].size())
+        i = j;
+    break;
+
+  case RANDOM_SEARCH:
+    i = std::uniform_int_distribution<size_t>(
+      0, m_pending_flips.size() - 1)(m_random);
+    break;
+
+  case COVERAGE_SEARCH:
+    {
+      unsigned long long min_coverage =
+        std::numeric_limits<unsigned long long>::max();
+      for (size_t j = 0; j < m_pending_flips.size(); j++)
+      {
+        const Flip& flip = m_pending_flips[j].back();
+        const auto iter = m_coverage.find(
+          coverage_key(flip.events_size, flip.direction));
+        const unsigned long long coverage =
+          iter == m_coverage.cend() ? 0 : iter->second;
+        if (coverage < min_coverage)
+        {
+          min_coverage = coverage;
+          i = j;
+        }
+      }
+    }
+    break;
+
+  default:
+    assert(false);
+  }
+
+  // the current and next path share the guards before flip_index
+  FlipList& flips = m_pending_flips[i];
+  flip_index = 0;
+  for (FlipIter iter = m_flips.cbegin(), next_iter = flips.cbegin();
+       iter != m_flips.cend() && std::next(next_iter) != flips.cend() &&
+       iter->direction == next_iter->direction; ++iter, ++next_iter)
+    flip_index++;
+
+  m_flips = std::move(flips);
+  m_pending_flips.erase(m_pending_flips.begin() + i);
+  return true;
+}
+
+// Identifies records of Tracer::write() and their format version
+static const std::string s_trace_magic = "crv";
+static constexpr uint64_t s_trace_version = 1;
+
+smt::Error Tracer::write(std::ostream& out) const
+{
+  smt::BinaryWriter writer(out);
+  smt::Error err;
+
+  writer.write_string(s_trace_magic);
+  writer.write_uint(s_trace_version);
+  writer.write_uint(m_event_id_cnt);
+
+  writer.write_uint(m_events.guards_size());
+  for (GuardIdentifier guard_id = 0; guard_id < m_events.guards_size();
+       guard_id++)
+  {
+    err = writer.write_term(m_events.guard(guard_id));
+    if (err)
+      return err;
+  }
+
+  // clocks that follow from program order are omitted
+  DenseMap<ThreadIdentifier, ThreadClock> thread_clocks;
+  writer.write_uint(m_events.size());
+  for (EventList::const_iterator iter = m_events.cbegin();
+       iter != m_events.cend(); ++iter)
+  {
+    const Event& e = *iter;
+    writer.write_uint(e.kind);
+    writer.write_uint(e.event_id);
+    writer.write_uint(e.thread_id);
+    writer.write_uint(e.address);
+    writer.write_uint(e.guard_id);
+
+    err = writer.write_term(e.term);
+    if (err)
+      return err;
+
+    err = writer.write_term(e.offset_term);
+    if (err)
+      return err;
+
+    // the clock only differs from program order after synchronization
+    ThreadClock& thread_clock = thread_clocks[e.thread_id];
+    const EventClock& e_clock = m_event_clocks[iter.handle()];
+    if (thread_clock.snapshot == e_clock.snapshot)
+    {
+      writer.write_uint(0);
+    }
+    else
+    {
+      VectorClock& clock = thread_clock.clock;
+      clock = m_clock_snapshots[e_clock.snapshot];
+      if (clock.size() <= e.thread_id)
+        clock.resize(e.thread_id + 1, 0);
+
+      clock[e.thread_id] = e_clock.count;
+      writer.write_uint(clock.size() + 1);
+      for (const unsigned n : clock)
+        writer.write_uint(n);
+
+      thread_clock.snapshot = e_clock.snapshot;
+    }
+  }
+
+  err = writer.write_term(m_guard);
+  if (err)
+    return err;
+
+  writer.write_uint(m_guard_definitions.size());
+  for (const GuardDefinition& guard_definition : m_guard_definitions)
+  {
+    writer.write_uint(guard_definition.events_size);
+    err = writer.write_term(guard_definition.definition);
+    if (err)
+      return err;
+  }
+
+  writer.write_uint(m_assertions.size());
+  for (const smt::Bool& assertion : m_assertions)
+  {
+    err = writer.write_term(assertion);
+    if (err)
+      return err;
+  }
+
+  writer.write_uint(m_errors.size());
+  for (const smt::Bool& error : m_errors)
+  {
+    err = writer.write_term(error);
+    if (err)
+      return err;
+  }
+
+  return smt::OK;
+}
+
+bool Tracer::read(std::istream& in)
+{
+  if (in.peek() == std::char_traits<char>::eof())
+    return false;
+
+  smt::BinaryReader reader(in);
+  if (reader.read_string() != s_trace_magic ||
+      reader.read_uint() != s_trace_version)
+    throw std::runtime_error("crv::Tracer::read: unknown format");
+
+  reset_events();
+  reset_guard();
+  reset_assertions();
+  reset_errors();
+
+  m_event_id_cnt = reader.read_uint();
+
+  const uint64_t guards_size = reader.read_uint();
+  for (uint64_t i = 0; i < guards_size; i++)
+    m_events.push_guard(reader.read_term<smt::Bool>());
+
+  const uint64_t events_size = reader.read_uint();
+  for (uint64_t i = 0; i < events_size; i++)
+  {
+    const EventKind kind(static_cast<EventKind>(reader.read_uint()));
+    const EventIdentifier event_id(reader.read_uint());
+    const ThreadIdentifier thread_id(reader.read_uint());
+    const Address address(reader.read_uint());
+    const GuardIdentifier guard_id(reader.read_uint());
+    const smt::UnsafeTerm term(reader.read_term());
+    const smt::UnsafeTerm offset_term(reader.read_term());
+
+    const bool is_sync(kind == THREAD_BEGIN_EVENT ||
+      kind == THREAD_END_EVENT);
+    if (SEND_EVENT < kind || m_events.guards_size() <= guard_id ||
+        m_event_id_cnt <= event_id || thread_id == 0 ||
+        (!is_sync && (address == 0 || term.is_null())))
+      throw std::runtime_error("crv::Tracer::read: invalid event");
+
+    const EventHandle e_handle(m_events.push_back(Event(kind, event_id,
+      thread_id, address, guard_id, term, offset_term)));
+
+    EventKinds& a = m_per_address_map[address];
+    switch (kind)
+    {
+    case READ_EVENT:  a.push_back<READ_EVENT>(e_handle);  break;
+    case WRITE_EVENT: a.push_back<WRITE_EVENT>(e_handle); break;
+    case POP_EVENT:   a.push_back<POP_EVENT>(e_handle);   break;
+    case PUSH_EVENT:  a.push_back<PUSH_EVENT>(e_handle);  break;
+    case LOAD_EVENT:  a.push_back<LOAD_EVENT>(e_handle);  break;
+    case STORE_EVENT: a.push_back<STORE_EVENT>(e_handle); break;
+    case RECV_EVENT:  a.push_back<RECV_EVENT>(e_handle);  break;
+    case SEND_EVENT:  a.push_back<SEND_EVENT>(e_handle);  break;
+    default: break;
+    }
+    m_per_thread_map[thread_id].push_back(e_handle);
+
+    ThreadClock& thread_clock = m_thread_clocks[thread_id];
+    VectorClock& clock = thread_clock.clock;
+    if (clock.size() <= thread_id)
+      clock.resize(thread_id + 1, 0);
+
+    clock[thread_id]++;
+
+    const uint64_t clock_size = reader.read_uint();
+    if (0 < clock_size)
+    {
+      clock.resize(clock_size - 1);
+      for (unsigned& n : clock)
+        n = reader.read_uint();
+
+      snapshot_clock(thread_clock);
+    }
+    m_event_clocks.push_back(EventClock{clock[thread_id],
+      thread_clock.snapshot});
+
+    m_thread_id_cnt = std::max(m_thread_id_cnt, thread_id + 1);
+  }
+
+  m_guard = reader.read_term<smt::Bool>();
+
+  const uint64_t guard_definitions_size = reader.read_uint();
+  for (uint64_t i = 0; i < guard_definitions_size; i++)
+  {
+    const size_t events_size = reader.read_uint();
+    m_guard_definitions.push_back(GuardDefinition{events_size,
+      reader.read_term<smt::Bool>()});
+  }
+
+  const uint64_t assertions_size = reader.read_uint();
+  for (uint64_t i = 0; i < assertions_size; i++)
+    m_assertions.push_back(reader.read_term<smt::Bool>());
+
+  const uint64_t errors_size = reader.read_uint();
+  for (uint64_t i = 0; i < errors_size; i++)
+    m_errors.push_back(reader.read_term<smt::Bool>());
+
+  return true;
+}
+
+// Writes terms with the values of a thread's own events renamed to the
+// positions of the events in the thread, and collects all other values
+class ThreadWriter : public smt::BinaryWriter
+{
+private:
+  const std::string& m_value_prefix;
+  const std::unordered_map<uint64_t, uint64_t>& m_positions;
+  std::unordered_set<uint64_t>& m_value_ids;
+
+protected:
+  virtual void write_symbol(const smt::UnsafeDecl& decl) override
+  {
+    if (decl.is_keyed() && m_value_prefix == decl.prefix())
+    {
+      const std::unordered_map<uint64_t, uint64_t>::const_iterator iter(
+        m_positions.find(decl.id()));
+      if (iter != m_positions.cend())
+      {
+        // no symbol is empty
+        write_string("");
+        write_uint(iter->second);
+        return;
+      }
+      m_value_ids.insert(decl.id());
+    }
+    smt::BinaryWriter::write_symbol(decl);
+  }
+
+public:
+  ThreadWriter(
+    std::ostream& out,
+    const std::string& value_prefix,
+    const std::unordered_map<uint64_t, uint64_t>& positions,
+    std::unordered_set<uint64_t>& value_ids)
+  : smt::BinaryWriter(out),
+    m_value_prefix(value_prefix),
+    m_positions(positions),
+    m_value_ids(value_ids) {}
+};
+
+// Collects the identifiers of values in terms without encoding them
+class ValueCollector : public smt::Solver
+{
+private:
+  const std::string& m_value_prefix;
+  std::unordered_set<uint64_t>& m_value_ids;
+
+  // shared subterms are only visited once across all collect() calls
+  std::unordered_set<uintptr_t> m_visited;
+
+  smt::Error visit(const smt::UnsafeTerm& term)
+  {
+    if (!m_visited.insert(term.addr()).second)
+      return smt::OK;
+
+    return term.encode(*this);
+  }
+
+  void visit_symbol(const smt::UnsafeDecl& decl)
+  {
+    if (decl.is_keyed() && m_value_prefix == decl.prefix())
+      m_value_ids.insert(decl.id());
+  }
+
+#define CRV_COLLECT_BUILTIN_LITERAL(type) \
+  virtual smt::Error __encode_literal(    \
+    const smt::Sort& sort,                \
+    type literal) override                \
+  {                                       \
+    return smt::OK;                       \
+  }                                       \
+
+CRV_COLLECT_BUILTIN_LITERAL(bool)
+CRV_COLLECT_BUILTIN_LITERAL(char)
+CRV_COLLECT_BUILTIN_LITERAL(signed char)
+CRV_COLLECT_BUILTIN_LITERAL(unsigned char)
+CRV_COLLECT_BUILTIN_LITERAL(wchar_t)
+CRV_COLLECT_BUILTIN_LITERAL(char16_t)
+CRV_COLLECT_BUILTIN_LITERAL(char32_t)
+CRV_COLLECT_BUILTIN_LITERAL(short)
+CRV_COLLECT_BUILTIN_LITERAL(unsigned short)
+CRV_COLLECT_BUILTIN_LITERAL(int)
+CRV_COLLECT_BUILTIN_LITERAL(unsigned int)
+CRV_COLLECT_BUILTIN_LITERAL(long)
+CRV_COLLECT_BUILTIN_LITERAL(unsigned long)
+CRV_COLLECT_BUILTIN_LITERAL(long long)
+CRV_COLLECT_BUILTIN_LITERAL(unsigned long long)
+
+#undef CRV_COLLECT_BUILTIN_LITERAL
+
+  virtual smt::Error __encode_constant(
+    const smt::UnsafeDecl& decl) override
+  {
+    visit_symbol(decl);
+    return smt::OK;
+  }
+
+  virtual smt::Error __encode_func_app(
+    const smt::UnsafeDecl& func_decl,
+    const size_t arity,
+    const smt::UnsafeTerm* const args) override
+  {
+    visit_symbol(func_decl);
+
+    smt::Error err = smt::OK;
+    for (size_t i = 0; i < arity && !err; i++)
+      err = visit(args[i]);
+
+    return err;
+  }
+
+  virtual smt::Error __encode_const_array(
+    const smt::Sort& sort,
+    const smt::UnsafeTerm& init) override
+  {
+    return visit(init);
+  }
+
+  virtual smt::Error __encode_array_select(
+    const smt::UnsafeTerm& array,
+    const smt::UnsafeTerm& index) override
+  {
+    const smt::Error err = visit(array);
+    if (err)
+      return err;
+
+    return visit(index);
+  }
+
+  virtual smt::Error __encode_array_store(
+    const smt::UnsafeTerm& array,
+    const smt::UnsafeTerm& index,
+    const smt::UnsafeTerm& value) override
+  {
+    smt::Error err = visit(array);
+    if (err)
+      return err;
+
+    err = visit(index);
+    if (err)
+      return err;
+
+    return visit(value);
+  }
+
+  virtual smt::Error __encode_unary(
+    smt::Opcode opcode,
+    const smt::Sort& sort,
+    const smt::UnsafeTerm& arg) override
+  {
+    return visit(arg);
+  }
+
+  virtual smt::Error __encode_binary(
+    smt::Opcode opcode,
+    const smt::Sort& sort,
+    const smt::UnsafeTerm& larg,
+    const smt::UnsafeTerm& rarg) override
+  {
+    const smt::Error err = visit(larg);
+    if (err)
+      return err;
+
+    return visit(rarg);
+  }
+
+  virtual smt::Error __encode_nary(
+    smt::Opcode opcode,
+    const smt::Sort& sort,
+    const smt::UnsafeTerms& args) override
+  {
+    smt::Error err = smt::OK;
+    for (size_t i = 0; i < args.size() && !err; i++)
+      err = visit(args[i]);
+
+    return err;
+  }
+
+  // never used as a solver
+  virtual void __reset() override { m_visited.clear(); }
+  virtual void __push() override {}
+  virtual void __pop() override {}
+
+  virtual smt::Error __add(const smt::Bool& condition) override
+  {
+    return collect(condition);
+  }
+
+  virtual smt::Error __unsafe_add(
+    const smt::UnsafeTerm& condition) override
+  {
+    return collect(condition);
+  }
+
+  virtual smt::CheckResult __check() override
+  {
+    return smt::unknown;
+  }
+
+public:
+  ValueCollector(
+    const std::string& value_prefix,
+    std::unordered_set<uint64_t>& value_ids)
+  : m_value_prefix(value_prefix),
+    m_value_ids(value_ids),
+    m_visited() {}
+
+  // null terms, e.g. events without an offset term, have no values
+  smt::Error collect(const smt::UnsafeTerm& term)
+  {
+    if (term.is_null())
+      return smt::OK;
+
+    return visit(term);
+  }
+};
+
+std::vector<ThreadIdentifiers> Tracer::symmetric_threads() const
+{
+  std::vector<ThreadIdentifiers> groups;
+
+  // values that are used outside of the thread of their event
+  std::unordered_set<uint64_t> value_ids;
+
+  // events of candidates, except for thread begin and end events
+  std::unordered_map<ThreadIdentifier, std::string> shapes;
+
+  for (const PerThreadMap::value_type& pair : m_per_thread_map)
+  {
+    const EventHandles& e_handles = pair.second;
+    std::unordered_map<uint64_t, uint64_t> positions;
+    for (size_t i = 0; i < e_handles.size(); i++)
+      positions.emplace(m_events[e_handles[i]].event_id, i);
+
+    bool is_candidate = 2 < e_handles.size() &&
+      m_events[e_handles.front()].is_thread_begin() &&
+      m_events[e_handles.back()].is_thread_end();
+
+    std::ostringstream out;
+    ThreadWriter writer(out, s_value_prefix, positions, value_ids);
+    for (size_t i = 0; i < e_handles.size(); i++)
+    {
+      const Event& e = m_events[e_handles[i]];
+      if (e.is_sync())
+      {
+        // spawns or joins other threads
+        if (0 < i && i + 1 < e_handles.size())
+          is_candidate = false;
+
+        continue;
+      }
+
+      writer.write_uint(e.kind);
+      writer.write_uint(e.address);
+      writer.write_uint(e.guard_id);
+
+      // without knowing which values are used, nothing is symmetric
+      if (writer.write_term(e.term) || writer.write_term(e.offset_term))
+        return groups;
+    }
+
+    if (is_candidate)
+      shapes.emplace(pair.first, out.str());
+  }
+
+  {
+    ValueCollector collector(s_value_prefix, value_ids);
+    for (const GuardDefinition& guard_definition : m_guard_definitions)
+      if (collector.collect(guard_definition.definition))
+        return groups;
+
+    for (const smt::Bool& assertion : m_assertions)
+      if (collector.collect(assertion))
+        return groups;
+
+    for (const smt::Bool& error : m_errors)
+      if (collector.collect(error))
+        return groups;
+  }
+
+  // join events have the identifier of the thread end event they join
+  std::unordered_map<EventIdentifier, EventHandle> end_map, join_map;
+  for (EventHandle e_handle = 0; e_handle < m_events.size(); e_handle++)
+  {
+    const Event& e = m_events[e_handle];
+    if (e.is_thread_end() && !end_map.emplace(e.event_id, e_handle).second)
+      join_map.emplace(e.event_id, e_handle);
+  }
+
+  // candidates by the event with which they begin
+  std::vector<std::pair<EventHandle, ThreadIdentifier>> spawns;
+  for (const std::pair<const ThreadIdentifier, std::string>& shape : shapes)
+  {
+    const EventHandles& e_handles = m_per_thread_map.at(shape.first);
+    if (std::none_of(e_handles.cbegin(), e_handles.cend(),
+          [&](const EventHandle e_handle)
+          { return value_ids.count(m_events[e_handle].event_id); }))
+      spawns.emplace_back(e_handles.front(), shape.first);
+  }
+  std::sort(spawns.begin(), spawns.end());
+
+  // is y right after x in the same thread?
+  const auto is_next = [this](const EventHandle x, const EventHandle y)
+  {
+    if (m_events[x].thread_id != m_events[y].thread_id)
+      return false;
+
+    const EventHandles& e_handles = m_per_thread_map.at(
+      m_events[x].thread_id);
+    const EventHandles::const_iterator iter(
+      std::lower_bound(e_handles.cbegin(), e_handles.cend(), x));
+    return std::next(iter) != e_handles.cend() && *std::next(iter) == y;
+  };
+
+  for (size_t i = 1; i < spawns.size(); i++)
+  {
+    const ThreadIdentifier x = spawns[i - 1].second;
+    const ThreadIdentifier y = spawns[i].second;
+    if (shapes.at(x) != shapes.at(y))
+      continue;
+
+    // the parent's begin event is right before the child's
+    if (!is_next(spawns[i - 1].first - 1, spawns[i].first - 1))
+      continue;
+
+    const std::unordered_map<EventIdentifier, EventHandle>::const_iterator
+      x_join(join_map.find(m_events[m_per_thread_map.at(x).back()].event_id)),
+      y_join(join_map.find(m_events[m_per_thread_map.at(y).back()].event_id));
+    if (x_join == join_map.cend() || y_join == join_map.cend())
+    {
+      if (x_join != y_join)
+        continue;
+    }
+    else if (!is_next(x_join->second, y_join->second))
+      continue;
+
+    if (groups.empty() || groups.back().back() != x)
+      groups.push_back(ThreadIdentifiers{x});
+
+    groups.back().push_back(y);
+  }
+
+  return groups;
+}
+
+std::vector<bool> Tracer::relevant_addresses(
+  const smt::UnsafeTerm& term) const
+{
+  Address address_max = 0;
+  for (const PerAddressMap::value_type& pair : m_per_address_map)
+    address_max = std::max(address_max, pair.first);
+
+  std::vector<bool> addresses(address_max + 1, false);
+
+  // values used by relevant terms
+  std::unordered_set<uint64_t> value_ids;
+  ValueCollector collector(s_value_prefix, value_ids);
+
+  // without knowing which values are used, everything is relevant
+  const std::vector<bool> all_addresses(address_max + 1, true);
+
+  for (const GuardDefinition& guard_definition : m_guard_definitions)
+    if (collector.collect(guard_definition.definition))
+      return all_addresses;
+
+  for (const smt::Bool& assertion : m_assertions)
+    if (collector.collect(assertion))
+      return all_addresses;
+
+  for (const smt::Bool& error : m_errors)
+    if (collector.collect(error))
+      return all_addresses;
+
+  if (collector.collect(term))
+    return all_addresses;
+
+  // addresses of reads by the identifier of their value
+  std::unordered_map<uint64_t, Address> read_map;
+  for (EventHandle e_handle = 0; e_handle < m_events.size(); e_handle++)
+  {
+    const Event& e = m_events[e_handle];
+    if (e.kind == READ_EVENT)
+      read_map.emplace(e.event_id, e.address);
+    else if (e.kind != WRITE_EVENT &&
+             (collector.collect(e.term) || collector.collect(e.offset_term)))
+      return all_addresses;
+  }
+
+  // a read that may happen before all writes constrains the other
+  // events even if its value is not used, see Encoder::set_slicing()
+  std::vector<Address> worklist;
+  for (const PerAddressMap::value_type& pair : m_per_address_map)
+  {
+    const EventKinds& a = pair.second;
+    if (std::any_of(a.reads().cbegin(), a.reads().cend(),
+          [&](const EventHandle r_handle)
+          {
+            return a.writes().empty() ||
+              !happens_before(a.writes().front(), r_handle);
+          }))
+    {
+      addresses[pair.first] = true;
+      worklist.push_back(pair.first);
+    }
+  }
+
+  std::unordered_set<uint64_t> visited_value_ids;
+  while (!worklist.empty() || visited_value_ids.size() < value_ids.size())
+  {
+    for (const uint64_t value_id : value_ids)
+    {
+      if (!visited_value_ids.insert(value_id).second)
+        continue;
+
+      const std::unordered_map<uint64_t, Address>::const_iterator iter(
+        read_map.find(value_id));
+      if (iter != read_map.cend() && !addresses[iter->second])
+      {
+        addresses[iter->second] = true;
+        worklist.push_back(iter->second);
+      }
+    }
+
+    // collecting values adds to value_ids, so only do that afterwards
+    while (!worklist.empty())
+    {
+      const Address address = worklist.back();
+      worklist.pop_back();
+      for (const EventHandle w_handle :
+           m_per_address_map.at(address).writes())
+        if (collector.collect(m_events[w_handle].term))
+          return all_addresses;
+    }
+  }
+
+  return addresses;
+}
+
+Explorer::Explorer(unsigned workers)
+: m_workers(workers == 0 ?
+    std::max(1U, std::thread::hardware_concurrency()) : workers),
+  m_is_guard_pruning(false),
+  m_solver_factory([](smt::Logic logic) -> smt::Solver*
+  {
+    return new smt::CVC4Solver(logic);
+  }),
+  m_mutex(),
+  m_cv(),
+  m_prefixes(),
+  m_idle_workers(0),
+  m_is_done(false),
+  m_stats{0},
+  m_error_paths() {}
+
+bool Explorer::pop_prefix(Directions& prefix)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_idle_workers++;
+  while (m_prefixes.empty() && !m_is_done)
+  {
+    // every worker is waiting for work that nobody can give away
+    if (m_idle_workers == m_workers)
+    {
+      m_is_done = true;
+      m_cv.notify_all();
+      break;
+    }
+    m_cv.wait(lock);
+  }
+  m_idle_workers--;
+
+  if (m_prefixes.empty())
+    return false;
+
+  prefix = std::move(m_prefixes.front());
+  m_prefixes.pop_front();
+  return true;
+}
+
+void Explorer::share_prefix(Tracer& tracer)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_idle_workers == 0 || !m_prefixes.empty())
+    return;
+
+  Directions prefix;
+  for (Flip& flip : tracer.flips())
+  {
+    if (flip.is_flip)
+    {
+      prefix.push_back(flip.direction);
+      continue;
+    }
+
+    // the other direction is now explored by another worker
+    flip.is_flip = true;
+    prefix.push_back(!flip.direction);
+    m_prefixes.push_back(std::move(prefix));
+    m_stats.steals++;
+    m_cv.notify_one();
+    return;
+  }
+}
+
+void Explorer::work(const Program& program)
+{
+  const TimeEncoding time_encoding(Encoder::default_time_encoding());
+  const smt::Logic logic(Encoder::logic(time_encoding));
+
+  // declared before the tracer so that it outlives its use
+  std::unique_ptr<smt::Solver> guard_solver;
+  TracerContext tracer_context;
+  Tracer& worker_tracer = tracer_context.tracer();
+  if (m_is_guard_pruning)
+  {
+    guard_solver.reset(m_solver_factory(logic));
+    worker_tracer.set_guard_solver(guard_solver.get());
+  }
+
+  const std::unique_ptr<smt::Solver> solver(m_solver_factory(logic));
+  Encoder encoder(*solver, time_encoding);
+  Stats stats{0};
+  std::vector<Directions> error_paths;
+
+  Directions prefix;
+  while (pop_prefix(prefix))
+  {
+    worker_tracer.reset(prefix);
+    do
+    {
+      program();
+      stats.paths++;
+
+      if (!worker_tracer.errors().empty())
+      {
+        stats.checks++;
+        switch (encoder.check(worker_tracer))
+        {
+        case smt::sat:
+          stats.errors++;
+          error_paths.emplace_back();
+          for (const Flip& flip : worker_tracer.flips())
+            error_paths.back().push_back(flip.direction);
+          break;
+        case smt::unknown:
+          stats.unknowns++;
+          break;
+        default:
+          break;
+        }
+      }
+
+      share_prefix(worker_tracer);
+    }
+    while (worker_tracer.flip());
+
+    stats.prunes += worker_tracer.prune_cnt();
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats.paths += stats.paths;
+  m_stats.checks += stats.checks;
+  m_stats.errors += stats.errors;
+  m_stats.unknowns += stats.unknowns;
+  m_stats.prunes += stats.prunes;
+  m_error_paths.insert(m_error_paths.end(),
+    error_paths.begin(), error_paths.end());
+}
+
+void Explorer::explore(const Program& program)
+{
+  m_prefixes.assign(1, Directions());
+  m_idle_workers = 0;
+  m_is_done = false;
+  m_stats = Stats{0};
+  m_error_paths.clear();
+
+  std::vector<std::thread> threads;
+  threads.reserve(m_workers);
+  for (unsigned i = 0; i < m_workers; i++)
+    threads.emplace_back(&Explorer::work, this, std::cref(program));
+
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
 namespace ThisThread
 {
   ThreadIdentifier thread_id()
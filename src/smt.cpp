@@ -4,18 +4,22 @@
 
 #include "smt.h"
 
+#include <mutex>
+
 namespace smt
 {
 
-constexpr const char* const Logics::acronyms[23];
+constexpr const char* const Logics::acronyms[24];
 
 static constexpr size_t MAX_BV_SIZE = 1024;
 static const Sort* bv_sorts[2][MAX_BV_SIZE] = { nullptr };
+static std::mutex bv_sorts_mutex;
 
 const Sort& bv_sort(bool is_signed, size_t size)
 {
   assert(size < MAX_BV_SIZE);
 
+  std::lock_guard<std::mutex> lock(bv_sorts_mutex);
   if (bv_sorts[is_signed][size] == nullptr) {
     bv_sorts[is_signed][size] = new Sort(
       false, false, false,
@@ -212,39 +216,134 @@ Error Solver::encode_nary(
   return __encode_nary(opcode, sort, args);
 }
 
+void Solver::ensure_idle() const
+{
+  if (m_checking) {
+    throw std::logic_error("solver is busy with check_async()");
+  }
+}
+
 void Solver::reset()
 {
+  ensure_idle();
   return __reset();
 }
 
 void Solver::push()
 {
+  ensure_idle();
   return __push();
 }
 
 void Solver::pop()
 {
+  ensure_idle();
   return __pop();
 }
 
 void Solver::unsafe_add(const UnsafeTerm& condition)
 {
   assert(condition.sort().is_bool());
+  ensure_idle();
   const Error err = __unsafe_add(condition);
   assert(err == OK);
 }
 
 void Solver::add(const Bool& condition)
 {
+  ensure_idle();
   const Error err = __unsafe_add(condition);
   assert(err == OK);
 }
 
 CheckResult Solver::check()
 {
+  ensure_idle();
+  m_interrupted = false;
   return __check();
 }
 
+CheckResult Solver::check_assumption(const Bool& assumption)
+{
+  ensure_idle();
+  m_interrupted = false;
+  return __check_assumption(assumption);
+}
+
+Error Solver::enable_models()
+{
+  ensure_idle();
+  return __enable_models();
+}
+
+Error Solver::get_value(const UnsafeTerm& term, long long& value)
+{
+  assert(term.sort().is_int() || term.sort().is_bv());
+  ensure_idle();
+  return __get_value(term, value);
+}
+
+std::unique_ptr<Solver> Solver::clone()
+{
+  ensure_idle();
+  return std::unique_ptr<Solver>(__clone());
+}
+
+Solver::CheckFuture Solver::check_async()
+{
+  bool is_checking = false;
+  if (!m_checking.compare_exchange_strong(is_checking, true)) {
+    throw std::logic_error("solver is busy with check_async()");
+  }
+  m_interrupted = false;
+
+  std::future<CheckResult> future;
+  try {
+    future = std::async(std::launch::async, [this]()
+    {
+      CheckResult result = unknown;
+      try {
+        {
+          // an earlier interrupt() has not been sent to the backend
+          std::lock_guard<std::mutex> lock(m_check_mutex);
+          m_is_backend_checking = !m_interrupted;
+        }
+        if (m_is_backend_checking) {
+          result = __check();
+
+          std::lock_guard<std::mutex> lock(m_check_mutex);
+          m_is_backend_checking = false;
+        }
+      } catch (...) {
+        {
+          std::lock_guard<std::mutex> lock(m_check_mutex);
+          m_is_backend_checking = false;
+        }
+        m_checking = false;
+        throw;
+      }
+      // result is only ready once the solver can be modified again
+      m_checking = false;
+      return result;
+    });
+  } catch (...) {
+    m_checking = false;
+    throw;
+  }
+  return CheckFuture(*this, std::move(future));
+}
+
+void Solver::interrupt()
+{
+  std::lock_guard<std::mutex> lock(m_check_mutex);
+  m_interrupted = true;
+
+  // check_async() skips the backend if it has not entered it yet
+  if (!m_checking || m_is_backend_checking) {
+    __interrupt();
+  }
+}
+
 Bool Identity<LAND, Bool>::term(literal<Bool>(true));
 
 }
@@ -98,6 +98,251 @@ TEST(CrvFunctionalTest, SatFib6)
   EXPECT_FALSE(crv::tracer().flip());
 }
 
+TEST(CrvFunctionalTest, UnsatFib6WithRankFromRead)
+{
+  constexpr unsigned N = 6;
+
+  crv::tracer().reset();
+  crv::Encoder encoder;
+  encoder.set_from_read_encoding(crv::RANK_FROM_READ);
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  crv::tracer().add_error(377 < i || 377 < j);
+
+  t0.join();
+  t1.join();
+
+  EXPECT_TRUE(smt::unsat == encoder.check(crv::tracer()));
+}
+
+TEST(CrvFunctionalTest, SatFib6WithRankFromRead)
+{
+  constexpr unsigned N = 6;
+
+  crv::tracer().reset();
+  crv::Encoder encoder;
+  encoder.set_from_read_encoding(crv::RANK_FROM_READ);
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  crv::tracer().add_error(377 <= i || 377 <= j);
+
+  t0.join();
+  t1.join();
+
+  EXPECT_TRUE(smt::sat == encoder.check(crv::tracer()));
+}
+
+TEST(CrvFunctionalTest, UnsatFib6Lazy)
+{
+  constexpr unsigned N = 6;
+
+  crv::tracer().reset();
+  crv::Encoder encoder;
+  EXPECT_EQ(smt::OK, encoder.set_lazy(true));
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  crv::tracer().add_error(377 < i || 377 < j);
+
+  t0.join();
+  t1.join();
+
+  EXPECT_TRUE(smt::unsat == encoder.check(crv::tracer()));
+}
+
+TEST(CrvFunctionalTest, SatFib6Lazy)
+{
+  constexpr unsigned N = 6;
+
+  crv::tracer().reset();
+  crv::Encoder encoder;
+  EXPECT_EQ(smt::OK, encoder.set_lazy(true));
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  crv::tracer().add_error(377 <= i || 377 <= j);
+
+  t0.join();
+  t1.join();
+
+  EXPECT_TRUE(smt::sat == encoder.check(crv::tracer()));
+}
+
+void difference_logic_t0(crv::External<int>& x)
+{
+  x = x + 1;
+}
+
+void difference_logic_t1(crv::External<int>& x, crv::External<int>& y)
+{
+  if (crv::tracer().append_guard(y < x))
+    x = x - 2;
+}
+
+// Data arithmetic that IDL_TIME supports
+TEST(CrvFunctionalTest, DifferenceLogicData)
+{
+  for (const bool is_sat : {false, true})
+  {
+    crv::tracer().reset();
+    crv::Encoder int_encoder(crv::INT_TIME), idl_encoder(crv::IDL_TIME);
+
+    crv::External<int> x = 0, y = -1;
+    crv::Thread t0(difference_logic_t0, x);
+    crv::Thread t1(difference_logic_t1, x, y);
+
+    t0.join();
+    t1.join();
+
+    if (is_sat)
+      crv::tracer().add_error(x == 1);
+    else
+      crv::tracer().add_error(x < -2 || 1 < x);
+
+    const smt::CheckResult result = is_sat ? smt::sat : smt::unsat;
+    EXPECT_EQ(result, int_encoder.check(crv::tracer()));
+    EXPECT_EQ(result, idl_encoder.check(crv::tracer()));
+  }
+}
+
+TEST(CrvFunctionalTest, LazyWithoutModels)
+{
+  smt::Z3Solver z3_solver(crv::Encoder::logic(crv::INT_TIME));
+  smt::CachingSolver solver(z3_solver);
+  crv::Encoder encoder(solver, crv::INT_TIME);
+
+  // the cache has no models
+  EXPECT_EQ(smt::UNSUPPORT_ERROR, encoder.set_lazy(true));
+  EXPECT_FALSE(encoder.is_lazy());
+}
+
+TEST(CrvFunctionalTest, UnsatFib6WithBvTime)
+{
+  constexpr unsigned N = 6;
+
+  crv::tracer().reset();
+  crv::Encoder encoder(crv::BV_TIME);
+  EXPECT_EQ(crv::BV_TIME, encoder.time_encoding());
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  crv::tracer().add_error(377 < i || 377 < j);
+
+  t0.join();
+  t1.join();
+
+  EXPECT_TRUE(smt::unsat == encoder.check(crv::tracer()));
+}
+
+TEST(CrvFunctionalTest, SatFib6WithBvTime)
+{
+  constexpr unsigned N = 6;
+
+  crv::tracer().reset();
+  crv::Encoder encoder(crv::BV_TIME);
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  crv::tracer().add_error(377 <= i || 377 <= j);
+
+  t0.join();
+  t1.join();
+
+  EXPECT_TRUE(smt::sat == encoder.check(crv::tracer()));
+}
+
+TEST(CrvFunctionalTest, UnsatFib6WithZ3)
+{
+  constexpr unsigned N = 6;
+
+  crv::tracer().reset();
+  smt::Z3Solver solver(crv::Encoder::logic(crv::INT_TIME));
+  crv::Encoder encoder(solver, crv::INT_TIME);
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  crv::tracer().add_error(377 < i || 377 < j);
+
+  t0.join();
+  t1.join();
+
+  EXPECT_TRUE(smt::unsat == encoder.check(crv::tracer()));
+}
+
+TEST(CrvFunctionalTest, SatFib6WithZ3)
+{
+  constexpr unsigned N = 6;
+
+  crv::tracer().reset();
+  smt::Z3Solver solver(crv::Encoder::logic(crv::BV_TIME));
+  crv::Encoder encoder(solver, crv::BV_TIME);
+
+  crv::External<int> i = 1, j = 1;
+  crv::Thread t0(fib_t0, N, i, j);
+  crv::Thread t1(fib_t1, N, i, j);
+
+  crv::tracer().add_error(377 <= i || 377 <= j);
+
+  t0.join();
+  t1.join();
+
+  EXPECT_TRUE(smt::sat == encoder.check(crv::tracer()));
+}
+
+TEST(CrvFunctionalTest, ReplayFib6)
+{
+  constexpr unsigned N = 6;
+
+  std::stringstream out;
+  for (const bool is_sat : {false, true})
+  {
+    crv::tracer().reset();
+
+    crv::External<int> i = 1, j = 1;
+    crv::Thread t0(fib_t0, N, i, j);
+    crv::Thread t1(fib_t1, N, i, j);
+
+    if (is_sat)
+      crv::tracer().add_error(377 <= i || 377 <= j);
+    else
+      crv::tracer().add_error(377 < i || 377 < j);
+
+    t0.join();
+    t1.join();
+
+    EXPECT_EQ(smt::OK, crv::tracer().write(out));
+  }
+
+  smt::Z3Solver solver(crv::Encoder::logic(crv::INT_TIME));
+  crv::Encoder encoder(solver, crv::INT_TIME);
+  crv::Tracer tracer;
+
+  EXPECT_TRUE(tracer.read(out));
+  EXPECT_EQ(crv::tracer().events().size(), tracer.events().size());
+  EXPECT_TRUE(smt::unsat == encoder.check(tracer));
+
+  EXPECT_TRUE(tracer.read(out));
+  EXPECT_TRUE(smt::sat == encoder.check(tracer));
+
+  EXPECT_FALSE(tracer.read(out));
+}
+
 void stateful_t0(
   crv::Mutex& mutex,
   crv::External<int>& i,
@@ -352,3 +597,213 @@ TEST(CrvFunctionalTest, UnsatCommunication)
   EXPECT_EQ(smt::unsat, encoder.check_deadlock(crv::tracer()));
 }
 
+
+void incremental_t0(crv::External<int>& x, crv::External<int>& y)
+{
+  if (crv::tracer().append_guard(x < 3))
+    y = y + 1;
+  else
+    y = y - 1;
+
+  if (crv::tracer().append_guard(y == x))
+    x = 5;
+}
+
+void incremental_t1(crv::External<int>& x, crv::External<int>& y)
+{
+  x = x + 1;
+  if (crv::tracer().append_guard(0 < y))
+    x = y;
+}
+
+TEST(CrvFunctionalTest, Incremental)
+{
+  crv::tracer().reset();
+  crv::Encoder encoder, incremental_encoder, rank_encoder, lazy_encoder;
+  crv::Encoder bv_encoder(crv::BV_TIME), idl_encoder(crv::IDL_TIME);
+  crv::Encoder slicing_encoder, forwarding_encoder;
+  incremental_encoder.set_incremental(true);
+  EXPECT_TRUE(incremental_encoder.is_incremental());
+  rank_encoder.set_incremental(true);
+  rank_encoder.set_from_read_encoding(crv::RANK_FROM_READ);
+  lazy_encoder.set_incremental(true);
+  EXPECT_EQ(smt::OK, lazy_encoder.set_lazy(true));
+  bv_encoder.set_incremental(true);
+  slicing_encoder.set_slicing(true);
+  forwarding_encoder.set_forwarding(true);
+
+  unsigned sat_cnt = 0, path_cnt = 0;
+  do
+  {
+    crv::External<int> x(0), y(2);
+
+    crv::Thread t0(incremental_t0, x, y);
+    crv::Thread t1(incremental_t1, x, y);
+
+    t0.join();
+    t1.join();
+
+    crv::tracer().add_error(x == y);
+
+    const smt::CheckResult result = encoder.check(crv::tracer());
+    EXPECT_EQ(result, incremental_encoder.check(crv::tracer()));
+    EXPECT_EQ(result, rank_encoder.check(crv::tracer()));
+    EXPECT_EQ(result, lazy_encoder.check(crv::tracer()));
+    EXPECT_EQ(result, bv_encoder.check(crv::tracer()));
+    EXPECT_EQ(result, idl_encoder.check(crv::tracer()));
+    EXPECT_EQ(result, slicing_encoder.check(crv::tracer()));
+    EXPECT_EQ(result, forwarding_encoder.check(crv::tracer()));
+    if (smt::sat == result)
+      sat_cnt++;
+
+    path_cnt++;
+  }
+  while (crv::tracer().flip());
+
+  EXPECT_TRUE(0 < sat_cnt);
+  EXPECT_TRUE(sat_cnt < path_cnt);
+}
+
+void explorer_program()
+{
+  crv::External<int> x(0), y(2);
+
+  crv::Thread t0(incremental_t0, x, y);
+  crv::Thread t1(incremental_t1, x, y);
+
+  t0.join();
+  t1.join();
+
+  crv::tracer().add_error(x == y);
+}
+
+TEST(CrvFunctionalTest, Explorer)
+{
+  crv::tracer().reset();
+  crv::Encoder encoder;
+
+  unsigned long long path_cnt = 0, error_cnt = 0;
+  do
+  {
+    explorer_program();
+    if (smt::sat == encoder.check(crv::tracer()))
+      error_cnt++;
+
+    path_cnt++;
+  }
+  while (crv::tracer().flip());
+
+  const size_t events_size = crv::tracer().events().size();
+
+  crv::Explorer explorer(4);
+  explorer.explore(explorer_program);
+
+  EXPECT_EQ(path_cnt, explorer.stats().paths);
+  EXPECT_EQ(path_cnt, explorer.stats().checks);
+  EXPECT_EQ(error_cnt, explorer.stats().errors);
+  EXPECT_EQ(0, explorer.stats().unknowns);
+  EXPECT_EQ(error_cnt, explorer.error_paths().size());
+
+  // the global tracer is unaffected
+  EXPECT_EQ(events_size, crv::tracer().events().size());
+}
+
+void guard_pruning_program()
+{
+  crv::External<int> x;
+  crv::Internal<int> a(x);
+
+  if (crv::tracer().append_guard(a < 3))
+    x = 1;
+
+  // infeasible if a < 3
+  if (crv::tracer().append_guard(3 < a))
+    x = 2;
+
+  crv::tracer().add_error(x == 2);
+}
+
+TEST(CrvFunctionalTest, GuardPruning)
+{
+  smt::Z3Solver guard_solver;
+  crv::tracer().reset();
+  crv::tracer().set_guard_solver(&guard_solver);
+  crv::Encoder encoder;
+
+  unsigned long long path_cnt = 0, error_cnt = 0;
+  do
+  {
+    guard_pruning_program();
+    if (smt::sat == encoder.check(crv::tracer()))
+      error_cnt++;
+
+    path_cnt++;
+  }
+  while (crv::tracer().flip());
+
+  EXPECT_EQ(3, path_cnt);
+  EXPECT_EQ(1, error_cnt);
+  EXPECT_EQ(1, crv::tracer().prune_cnt());
+
+  crv::tracer().set_guard_solver(nullptr);
+
+  crv::Explorer explorer(2);
+  explorer.explore(guard_pruning_program);
+  EXPECT_EQ(4, explorer.stats().paths);
+  EXPECT_EQ(0, explorer.stats().prunes);
+
+  explorer.set_guard_pruning(true);
+  explorer.explore(guard_pruning_program);
+  EXPECT_EQ(3, explorer.stats().paths);
+  EXPECT_EQ(1, explorer.stats().prunes);
+  EXPECT_EQ(1, explorer.stats().errors);
+
+  std::atomic<unsigned> solver_cnt(0);
+  explorer.set_solver_factory([&solver_cnt](smt::Logic logic)
+  {
+    solver_cnt++;
+    return new smt::Z3Solver(logic);
+  });
+  explorer.explore(guard_pruning_program);
+  EXPECT_EQ(3, explorer.stats().paths);
+  EXPECT_EQ(1, explorer.stats().prunes);
+  EXPECT_EQ(1, explorer.stats().errors);
+
+  // an encoder and guard solver per worker
+  EXPECT_EQ(4, solver_cnt);
+}
+
+TEST(CrvFunctionalTest, SearchStrategy)
+{
+  smt::Z3Solver guard_solver;
+  for (const crv::SearchStrategy search_strategy :
+       {crv::BFS_SEARCH, crv::RANDOM_SEARCH, crv::COVERAGE_SEARCH})
+  {
+    crv::tracer().set_search_strategy(search_strategy);
+    crv::tracer().set_guard_solver(&guard_solver);
+    crv::tracer().reset();
+    crv::Encoder encoder, incremental_encoder;
+    incremental_encoder.set_incremental(true);
+
+    unsigned sat_cnt = 0, path_cnt = 0;
+    do
+    {
+      explorer_program();
+
+      const smt::CheckResult result = encoder.check(crv::tracer());
+      EXPECT_EQ(result, incremental_encoder.check(crv::tracer()));
+      if (smt::sat == result)
+        sat_cnt++;
+
+      path_cnt++;
+    }
+    while (crv::tracer().flip());
+
+    EXPECT_TRUE(0 < sat_cnt);
+    EXPECT_TRUE(sat_cnt < path_cnt);
+    EXPECT_FALSE(crv::tracer().is_budget_exhausted());
+  }
+
+  crv::tracer().set_search_strategy(crv::DFS_SEARCH);
+  crv::tracer().set_guard_solver(nullptr);
+}
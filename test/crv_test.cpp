@@ -18,18 +18,201 @@ TEST(CrvTest, Event)
   tracer().reset();
 
   EXPECT_TRUE(tracer().events().empty());
-  Event e(READ_EVENT, 2, 3, 5, smt::literal<smt::Bool>(true),
+  Event e(READ_EVENT, 2, 3, 5, 7,
     smt::any<smt::Bv<char>>("a"), smt::Bv<size_t>());
   EXPECT_EQ(READ_EVENT, e.kind);
   EXPECT_EQ(2, e.event_id);
   EXPECT_EQ(3, e.thread_id);
   EXPECT_EQ(5, e.address);
-  EXPECT_FALSE(e.guard.is_null());
+  EXPECT_EQ(7, e.guard_id);
   EXPECT_FALSE(e.term.is_null());
   EXPECT_TRUE(e.offset_term.is_null());
   EXPECT_TRUE(tracer().events().empty());
 }
 
+TEST(CrvTest, EventList)
+{
+  EventList events;
+  EXPECT_TRUE(events.empty());
+
+  const GuardIdentifier guard_id(
+    events.push_guard(smt::literal<smt::Bool>(true)));
+  EXPECT_EQ(0, guard_id);
+  EXPECT_EQ(1, events.guards_size());
+
+  constexpr EventHandle n = 3000;
+  const Event* first = nullptr;
+  for (EventHandle i = 0; i < n; i++)
+  {
+    EXPECT_EQ(i, events.push_back(Event(WRITE_EVENT, i, 1, 1,
+      guard_id, smt::literal<smt::Int>(i), smt::UnsafeTerm())));
+
+    if (i == 0)
+      first = &events[0];
+  }
+
+  // events never move
+  EXPECT_EQ(first, &events[0]);
+  EXPECT_EQ(n, events.size());
+  EXPECT_EQ(n - 1, events.back().event_id);
+
+  EventIdentifier event_id = 0;
+  for (const Event& e : events)
+  {
+    EXPECT_EQ(event_id++, e.event_id);
+  }
+  EXPECT_EQ(n, event_id);
+
+  events.clear();
+  EXPECT_TRUE(events.empty());
+  EXPECT_EQ(0, events.guards_size());
+  EXPECT_EQ(events.cbegin(), events.cend());
+}
+
+TEST(CrvTest, GuardTable)
+{
+  tracer().reset();
+
+  External<int> x(0);
+  x = 1;
+  x = 2;
+
+  // events in the same guard region share one guard
+  EXPECT_EQ(1, tracer().events().guards_size());
+
+  tracer().append_guard(make_temporary_internal<bool>());
+  tracer().append_guard(make_temporary_internal<bool>());
+  x = 3;
+  x = 4;
+
+  // guards without events are not interned
+  EXPECT_EQ(2, tracer().events().guards_size());
+
+  const EventList& events = tracer().events();
+  const EventHandle n = events.size();
+  EXPECT_EQ(0, events[0].guard_id);
+  EXPECT_EQ(0, events[n - 3].guard_id);
+  EXPECT_EQ(1, events[n - 2].guard_id);
+  EXPECT_EQ(1, events[n - 1].guard_id);
+  EXPECT_EQ(tracer().guard().addr(), events.guard(1).addr());
+}
+
+TEST(CrvTest, ActivationLiterals)
+{
+  tracer().reset();
+
+  External<int> x(0);
+  EXPECT_TRUE(tracer().guard_definitions().empty());
+
+  tracer().append_guard(0 < x);
+  x = 1;
+  tracer().append_guard(x < 3);
+
+  const GuardDefinitions& definitions = tracer().guard_definitions();
+  EXPECT_EQ(2, definitions.size());
+  EXPECT_LT(definitions[0].events_size, definitions[1].events_size);
+
+  EXPECT_TRUE(tracer().flip());
+  EXPECT_TRUE(tracer().guard_definitions().empty());
+
+  // definitions are rebuilt along the replayed path
+  tracer().append_guard(0 < x);
+  EXPECT_EQ(1, tracer().guard_definitions().size());
+  EXPECT_EQ(tracer().events().size(),
+    tracer().guard_definitions()[0].events_size);
+}
+
+void write_read_t0(External<int>& x)
+{
+  x = x + 1;
+}
+
+TEST(CrvTest, WriteRead)
+{
+  tracer().reset();
+
+  External<int> x(0);
+  tracer().append_guard(0 < x);
+  Thread t0(write_read_t0, x);
+  x = 2;
+  t0.join();
+
+  tracer().add_assertion(x < 5);
+  tracer().add_error(x == 3);
+
+  std::stringstream out;
+  EXPECT_EQ(smt::OK, tracer().write(out));
+
+  Tracer replay;
+  EXPECT_TRUE(replay.read(out));
+  EXPECT_FALSE(replay.read(out));
+
+  const EventList& events = tracer().events();
+  const EventList& replay_events = replay.events();
+  EXPECT_EQ(events.size(), replay_events.size());
+  EXPECT_EQ(events.guards_size(), replay_events.guards_size());
+  EXPECT_EQ(tracer().event_id_cnt(), replay.event_id_cnt());
+  EXPECT_EQ(1, replay.guard_definitions().size());
+  EXPECT_EQ(1, replay.assertions().size());
+  EXPECT_EQ(1, replay.errors().size());
+
+  for (EventHandle x = 0; x < events.size(); x++)
+  {
+    EXPECT_EQ(events[x].kind, replay_events[x].kind);
+    EXPECT_EQ(events[x].event_id, replay_events[x].event_id);
+    EXPECT_EQ(events[x].thread_id, replay_events[x].thread_id);
+    EXPECT_EQ(events[x].address, replay_events[x].address);
+    EXPECT_EQ(events[x].guard_id, replay_events[x].guard_id);
+    EXPECT_EQ(events[x].term.is_null(), replay_events[x].term.is_null());
+
+    for (EventHandle y = 0; y < events.size(); y++)
+      EXPECT_EQ(tracer().happens_before(x, y), replay.happens_before(x, y));
+  }
+
+  EXPECT_EQ(tracer().per_address_map().size(),
+    replay.per_address_map().size());
+  EXPECT_EQ(tracer().per_thread_map().size(),
+    replay.per_thread_map().size());
+
+  std::stringstream malformed(out.str().substr(0, 8));
+  EXPECT_THROW(replay.read(malformed), std::runtime_error);
+}
+
+TEST(CrvTest, DenseMap)
+{
+  DenseMap<Address, EventHandles> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.contains(3));
+  EXPECT_THROW(map.at(3), std::out_of_range);
+
+  map[3].push_back(7);
+  map[1].push_back(5);
+  map[3].push_back(8);
+  EXPECT_EQ(2, map.size());
+  EXPECT_TRUE(map.contains(3));
+  EXPECT_FALSE(map.contains(2));
+  EXPECT_EQ(2, map.at(3).size());
+  EXPECT_EQ(1, map.at(1).size());
+
+  // insertion order
+  Address keys[2];
+  size_t i = 0;
+  for (const DenseMap<Address, EventHandles>::value_type& pair : map)
+  {
+    keys[i++] = pair.first;
+  }
+  EXPECT_EQ(2, i);
+  EXPECT_EQ(3, keys[0]);
+  EXPECT_EQ(1, keys[1]);
+
+  const size_t capacity = map.at(3).capacity();
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_FALSE(map.contains(3));
+  EXPECT_TRUE(map[3].empty());
+  EXPECT_EQ(capacity, map[3].capacity());
+}
+
 TEST(CrvTest, Tracer)
 {
   // counter for event identifiers is static
@@ -61,15 +244,15 @@ TEST(CrvTest, Tracer)
   EXPECT_EQ(2, tracer.per_address_map().size());
 
   EXPECT_EQ(1, tracer.per_address_map().at(external0.address).reads().size());
-  EXPECT_EQ(1, tracer.per_address_map().at(external0.address).reads().front()->event_id);
+  EXPECT_EQ(1, tracer.events()[tracer.per_address_map().at(external0.address).reads().front()].event_id);
 
   EXPECT_EQ(1, tracer.per_address_map().at(external0.address).writes().size());
-  EXPECT_EQ(0, tracer.per_address_map().at(external0.address).writes().front()->event_id);
+  EXPECT_EQ(0, tracer.events()[tracer.per_address_map().at(external0.address).writes().front()].event_id);
 
   EXPECT_EQ(0, tracer.per_address_map().at(external1.address).reads().size());
 
   EXPECT_EQ(1, tracer.per_address_map().at(external1.address).writes().size());
-  EXPECT_EQ(2, tracer.per_address_map().at(external1.address).writes().front()->event_id);
+  EXPECT_EQ(2, tracer.events()[tracer.per_address_map().at(external1.address).writes().front()].event_id);
 
   const ThreadIdentifier parent_thread_id(tracer.append_thread_begin_event());
   EXPECT_EQ(1, parent_thread_id);
@@ -96,14 +279,14 @@ TEST(CrvTest, Tracer)
   external2.term = tracer.append_load_event(external2);
   EXPECT_EQ(7, tracer.events().size());
   EXPECT_EQ(1, tracer.per_address_map().at(external2.address).loads().size());
-  EXPECT_EQ(5, tracer.per_address_map().at(external2.address).loads().front()->event_id);
+  EXPECT_EQ(5, tracer.events()[tracer.per_address_map().at(external2.address).loads().front()].event_id);
   EXPECT_EQ(0, tracer.per_address_map().at(external2.address).stores().size());
 
   tracer.append_store_event(external2);
   EXPECT_EQ(8, tracer.events().size());
   EXPECT_EQ(1, tracer.per_address_map().at(external2.address).loads().size());
   EXPECT_EQ(1, tracer.per_address_map().at(external2.address).stores().size());
-  EXPECT_EQ(6, tracer.per_address_map().at(external2.address).stores().front()->event_id);
+  EXPECT_EQ(6, tracer.events()[tracer.per_address_map().at(external2.address).stores().front()].event_id);
 }
 
 TEST(CrvTest, Flip)
@@ -147,6 +330,62 @@ TEST(CrvTest, Flip)
   EXPECT_EQ(3, tracer.flip_cnt());
 }
 
+// if (v < 0) { skip } ; if (v < 1)  { skip }
+static std::vector<Directions> search_paths(Tracer& tracer)
+{
+  External<long> v;
+  std::vector<Directions> paths;
+
+  tracer.reset();
+  do
+  {
+    const bool direction0 = tracer.append_guard(v < 0);
+    const bool direction1 = tracer.append_guard(v < 1);
+    paths.push_back(Directions{direction0, direction1});
+  }
+  while (tracer.flip());
+  return paths;
+}
+
+TEST(CrvTest, SearchStrategy)
+{
+  Tracer tracer;
+  EXPECT_EQ(DFS_SEARCH, tracer.search_strategy());
+  EXPECT_EQ((std::vector<Directions>{{true, true}, {true, false},
+    {false, true}, {false, false}}), search_paths(tracer));
+
+  tracer.set_search_strategy(BFS_SEARCH);
+  EXPECT_EQ((std::vector<Directions>{{true, true}, {false, true},
+    {true, false}, {false, false}}), search_paths(tracer));
+  EXPECT_EQ(3, tracer.flip_cnt());
+  EXPECT_EQ(0, tracer.prefix_events_size());
+
+  for (const SearchStrategy search_strategy :
+       {RANDOM_SEARCH, COVERAGE_SEARCH})
+  {
+    tracer.set_search_strategy(search_strategy);
+    std::vector<Directions> paths(search_paths(tracer));
+    EXPECT_EQ(4, paths.size());
+    std::sort(paths.begin(), paths.end());
+    EXPECT_TRUE(std::unique(paths.begin(), paths.end()) == paths.cend());
+  }
+
+  tracer.set_search_strategy(DFS_SEARCH);
+  tracer.set_depth_bound(1);
+  EXPECT_EQ((std::vector<Directions>{{true, true}, {false, true}}),
+    search_paths(tracer));
+  EXPECT_FALSE(tracer.is_budget_exhausted());
+
+  tracer.set_depth_bound(0);
+  tracer.set_flip_budget(2);
+  EXPECT_EQ(3, search_paths(tracer).size());
+  EXPECT_TRUE(tracer.is_budget_exhausted());
+
+  tracer.set_flip_budget(0);
+  EXPECT_EQ(4, search_paths(tracer).size());
+  EXPECT_FALSE(tracer.is_budget_exhausted());
+}
+
 TEST(CrvTest, Value)
 {
   tracer().reset();
@@ -271,6 +510,106 @@ TEST(CrvTest, Value)
   }
 }
 
+TEST(CrvTest, LiteralFolding)
+{
+  tracer().reset();
+  Encoder encoder;
+
+  Internal<int> a(5);
+  Internal<int> b(3);
+  EXPECT_TRUE(a.is_literal());
+  EXPECT_FALSE(make_temporary_internal<int>().is_literal());
+
+  Internal<int> c(a + b * 2);
+  EXPECT_TRUE(c.is_literal());
+  EXPECT_EQ(11, c.literal());
+  EXPECT_EQ(-11, (-c).literal());
+  EXPECT_EQ(2, (c % 3).literal());
+  EXPECT_EQ(3, (11L / b).literal());
+  EXPECT_TRUE((c == 11).literal());
+  EXPECT_TRUE((!(a < b)).literal());
+
+  // the same values as the SMT terms over the integers
+  EXPECT_FALSE((Internal<unsigned>(1) - 3U).is_literal());
+  EXPECT_FALSE((Internal<int>(std::numeric_limits<int>::max()) + 1).is_literal());
+  EXPECT_FALSE((Internal<int>(std::numeric_limits<int>::min()) * -1).is_literal());
+  EXPECT_FALSE((-Internal<int>(std::numeric_limits<int>::min())).is_literal());
+  EXPECT_EQ(-12, (Internal<long>(-3) * 4).literal());
+  EXPECT_EQ(1U, (Internal<unsigned>(3) - 2U).literal());
+  EXPECT_FALSE((Internal<int>(-7) / 2).is_literal());
+  EXPECT_FALSE((a / 0).is_literal());
+  EXPECT_FALSE((Internal<int>(-1) < 1U).is_literal());
+  EXPECT_FALSE((a + make_temporary_internal<int>()).is_literal());
+
+  External<int> x(5);
+  EXPECT_FALSE((x + b).is_literal());
+
+  Internal<int> d(make_temporary_internal<int>());
+  d = c;
+  EXPECT_TRUE(d.is_literal());
+
+  EXPECT_EQ(smt::sat, encoder.check(c == 11, tracer()));
+  EXPECT_EQ(smt::unsat, encoder.check(c != 11, tracer()));
+  EXPECT_EQ(smt::sat, encoder.check(
+    Internal<unsigned>(1) - 3U == -2, tracer()));
+}
+
+TEST(CrvTest, TracerContext)
+{
+  Tracer& global_tracer = tracer();
+  Tracer local_tracer;
+  {
+    TracerContext context(local_tracer);
+    EXPECT_EQ(&local_tracer, &tracer());
+    EXPECT_EQ(&local_tracer, &context.tracer());
+    {
+      TracerContext nested_context;
+      EXPECT_EQ(&nested_context.tracer(), &tracer());
+      EXPECT_NE(&local_tracer, &tracer());
+    }
+    EXPECT_EQ(&local_tracer, &tracer());
+
+    External<int> x(3);
+    EXPECT_FALSE(local_tracer.events().empty());
+  }
+  EXPECT_EQ(&global_tracer, &tracer());
+
+  // other OS threads use the global tracer unless they install their own
+  Tracer* thread_tracer = nullptr;
+  std::thread([&thread_tracer]() { thread_tracer = &tracer(); }).join();
+  EXPECT_EQ(&global_tracer, thread_tracer);
+}
+
+TEST(CrvTest, ConcurrentTracerContexts)
+{
+  constexpr unsigned N = 4;
+  smt::CheckResult results[N];
+
+  std::vector<std::thread> threads;
+  for (unsigned n = 0; n < N; n++)
+  {
+    threads.emplace_back([n, &results]()
+    {
+      TracerContext context;
+      Encoder encoder;
+
+      External<int> i(0);
+      for (unsigned k = 0; k < 5; k++)
+        i = i + 1;
+
+      // error is only reachable in even jobs
+      tracer().add_error(i == int(5 + n % 2));
+      results[n] = encoder.check(tracer());
+    });
+  }
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (unsigned n = 0; n < N; n++)
+    EXPECT_EQ(n % 2 == 0 ? smt::sat : smt::unsat, results[n]);
+}
+
 TEST(CrvTest, SatInsideThread)
 {
   tracer().reset();
@@ -1019,6 +1358,67 @@ TEST(CrvTest, JoinThreads)
   EXPECT_EQ(smt::sat, encoder.check(x == 'A', tracer()));
 }
 
+void symmetric_increment(External<int>& x)
+{
+  x = x + 1;
+}
+
+void symmetric_decrement(External<int>& x)
+{
+  x = x - 1;
+}
+
+TEST(CrvTest, SymmetricThreads)
+{
+  tracer().reset();
+  Encoder encoder, symmetry_encoder;
+  symmetry_encoder.set_symmetry_reduction(true);
+  EXPECT_TRUE(symmetry_encoder.is_symmetry_reduction());
+
+  External<int> x(0);
+  Thread t0(symmetric_increment, x);
+  Thread t1(symmetric_increment, x);
+  Thread t2(symmetric_increment, x);
+  Thread t3(symmetric_decrement, x);
+  t0.join();
+  t1.join();
+  t2.join();
+  t3.join();
+
+  EXPECT_EQ((std::vector<ThreadIdentifiers>{{2, 3, 4}}),
+    tracer().symmetric_threads());
+
+  Internal<int> a(x);
+  tracer().add_error(a == 3);
+  EXPECT_EQ(smt::sat, encoder.check(tracer()));
+  EXPECT_EQ(smt::sat, symmetry_encoder.check(tracer()));
+  EXPECT_EQ(2, symmetry_encoder.stats().symmetric_threads);
+
+  tracer().reset_errors();
+  tracer().add_error(a == 4 || a < -1);
+  EXPECT_EQ(smt::unsat, encoder.check(tracer()));
+  EXPECT_EQ(smt::unsat, symmetry_encoder.check(tracer()));
+
+  // spawns are not adjacent
+  tracer().reset();
+  External<int> y(0);
+  Thread t4(symmetric_increment, y);
+  y = 5;
+  Thread t5(symmetric_increment, y);
+  t4.join();
+  t5.join();
+  EXPECT_TRUE(tracer().symmetric_threads().empty());
+
+  // joins are in a different order than spawns
+  tracer().reset();
+  External<int> z(0);
+  Thread t6(symmetric_increment, z);
+  Thread t7(symmetric_increment, z);
+  t7.join();
+  t6.join();
+  EXPECT_TRUE(tracer().symmetric_threads().empty());
+}
+
 void array_t0(External<char[]>& array)
 {
   array[0] = 'X';
@@ -1638,6 +2038,160 @@ TEST(CrvTest, MutexJoinMultipleWriters)
   EXPECT_EQ(smt::unsat, encoder.check(!(x == 16 && y == 5), tracer()));
 }
 
+TEST(CrvTest, HappensBefore)
+{
+  tracer().reset();
+
+  External<int> x(0);
+  x = 1;
+
+  const ThreadIdentifier parent_thread_id =
+    tracer().append_thread_begin_event();
+  Internal<int> a(x);
+  x = 2;
+  const ThreadIdentifier child_thread_id =
+    tracer().append_thread_end_event();
+  EXPECT_NE(parent_thread_id, child_thread_id);
+
+  Internal<int> b(x);
+  tracer().append_join_event(child_thread_id);
+  Internal<int> c(x);
+
+  const EventKinds& e_kinds = tracer().per_address_map().at(x.address);
+  ASSERT_EQ(3, e_kinds.writes().size());
+  ASSERT_EQ(3, e_kinds.reads().size());
+
+  const EventHandle w0 = e_kinds.writes()[0];
+  const EventHandle w1 = e_kinds.writes()[1];
+  const EventHandle w2 = e_kinds.writes()[2];
+  const EventHandle r0 = e_kinds.reads()[0];
+  const EventHandle r1 = e_kinds.reads()[1];
+  const EventHandle r2 = e_kinds.reads()[2];
+
+  EXPECT_TRUE(tracer().happens_before(w0, w1));
+  EXPECT_FALSE(tracer().happens_before(w1, w0));
+  EXPECT_TRUE(tracer().happens_before(w1, r0));
+  EXPECT_TRUE(tracer().happens_before(r0, w2));
+  EXPECT_TRUE(tracer().happens_before(w2, r2));
+  EXPECT_TRUE(tracer().happens_before(r1, r2));
+
+  // concurrent events
+  EXPECT_FALSE(tracer().happens_before(r1, w2));
+  EXPECT_FALSE(tracer().happens_before(w2, r1));
+  EXPECT_FALSE(tracer().happens_before(r0, r1));
+  EXPECT_FALSE(tracer().happens_before(r1, r0));
+
+  Encoder encoder;
+  EXPECT_EQ(smt::sat, encoder.check(a == 1 && b == 2 && c == 2, tracer()));
+
+  // a = 1, b is either 1 or 2, c = 2
+  EXPECT_EQ(5, encoder.stats().pruned_rf);
+  EXPECT_EQ(smt::unsat, encoder.check(!(a == 1), tracer()));
+  EXPECT_EQ(smt::sat, encoder.check(b == 1, tracer()));
+  EXPECT_EQ(smt::unsat, encoder.check(!(c == 2), tracer()));
+
+  encoder.set_happens_before_pruning(false);
+  EXPECT_EQ(smt::unsat, encoder.check(!(a == 1), tracer()));
+  EXPECT_EQ(smt::sat, encoder.check(b == 1, tracer()));
+  EXPECT_EQ(smt::unsat, encoder.check(!(c == 2), tracer()));
+}
+
+void slicing_t0(External<int>& x, External<int>& y, External<int>& z)
+{
+  x = x + 1;
+  y = y + 1;
+  z = x;
+}
+
+TEST(CrvTest, Slicing)
+{
+  tracer().reset();
+  Encoder encoder, slicing_encoder;
+  slicing_encoder.set_slicing(true);
+  EXPECT_TRUE(slicing_encoder.is_slicing());
+
+  External<int> x(0), y(0), z(0);
+  Thread t0(slicing_t0, x, y, z);
+  Thread t1(slicing_t0, x, y, z);
+  t0.join();
+  t1.join();
+
+  Internal<int> a(z);
+  tracer().add_error(a == 2);
+
+  // z depends on x, but not on y
+  std::vector<bool> addresses(tracer().relevant_addresses());
+  ASSERT_LT(z.address, addresses.size());
+  EXPECT_TRUE(addresses[x.address]);
+  EXPECT_FALSE(addresses[y.address]);
+  EXPECT_TRUE(addresses[z.address]);
+
+  EXPECT_EQ(smt::sat, encoder.check(tracer()));
+  EXPECT_EQ(smt::sat, slicing_encoder.check(tracer()));
+  EXPECT_EQ(1, slicing_encoder.stats().sliced_addresses);
+
+  tracer().reset_errors();
+  tracer().add_error(a == 3 || a < 1);
+  EXPECT_EQ(smt::unsat, encoder.check(tracer()));
+  EXPECT_EQ(smt::unsat, slicing_encoder.check(tracer()));
+  EXPECT_EQ(2, slicing_encoder.stats().sliced_addresses);
+
+  // the condition is relevant, too
+  tracer().reset_errors();
+  EXPECT_EQ(smt::sat, slicing_encoder.check(y == 1, tracer()));
+  EXPECT_EQ(smt::unsat, slicing_encoder.check(y == 3, tracer()));
+
+  // y twice, then x and z twice
+  EXPECT_EQ(6, slicing_encoder.stats().sliced_addresses);
+}
+
+void forwarding_t0(External<int>& x, External<int>& c)
+{
+  External<int> p(c);
+  p = p + x;
+  x = p;
+}
+
+TEST(CrvTest, Forwarding)
+{
+  tracer().reset();
+  Encoder encoder, forwarding_encoder;
+  forwarding_encoder.set_forwarding(true);
+  EXPECT_TRUE(forwarding_encoder.is_forwarding());
+
+  // c is written before the threads are spawned,
+  // and every thread has its own address p
+  External<int> x(0), c(1);
+  Thread t0(forwarding_t0, x, c);
+  Thread t1(forwarding_t0, x, c);
+  t0.join();
+  t1.join();
+
+  Internal<int> a(x);
+  tracer().add_error(a == 2);
+
+  EXPECT_EQ(smt::sat, encoder.check(tracer()));
+  EXPECT_EQ(smt::sat, forwarding_encoder.check(tracer()));
+  EXPECT_EQ(3, forwarding_encoder.stats().forwarded_addresses);
+
+  tracer().reset_errors();
+  tracer().add_error(a == 3 || a < 1);
+  EXPECT_EQ(smt::unsat, encoder.check(tracer()));
+  EXPECT_EQ(smt::unsat, forwarding_encoder.check(tracer()));
+  EXPECT_EQ(6, forwarding_encoder.stats().forwarded_addresses);
+
+  // only one write of c happens before the read
+  tracer().reset_errors();
+  EXPECT_EQ(smt::sat, forwarding_encoder.check(c == 1, tracer()));
+  EXPECT_EQ(smt::unsat, forwarding_encoder.check(c == 2, tracer()));
+
+  // along with slicing
+  tracer().reset_errors();
+  tracer().add_error(a == 1);
+  forwarding_encoder.set_slicing(true);
+  EXPECT_EQ(smt::sat, forwarding_encoder.check(tracer()));
+}
+
 TEST(CrvTest, CommunicationPredecessors)
 {
   tracer().reset();
@@ -1650,39 +2204,40 @@ TEST(CrvTest, CommunicationPredecessors)
   c.send(x);
   tracer().append_thread_end_event();
 
+  const EventList& events = tracer().events();
   const PerThreadMap& per_thread_map = tracer().per_thread_map();
   PerEventMap predecessors_map(
-    Encoder::build_predecessors_map(per_thread_map));
+    Encoder::build_predecessors_map(events, per_thread_map));
   EXPECT_FALSE(predecessors_map.empty());
 
-  EventIterList event_iters;
-  for (const EventIter e_iter : per_thread_map.at(2))
+  EventHandles e_handles;
+  for (const EventHandle e_handle : per_thread_map.at(2))
   {
-    if (e_iter->is_send() ||
-        e_iter->is_recv() || 
-        e_iter->is_thread_end())
-      event_iters.push_back(e_iter);
+    if (events[e_handle].is_send() ||
+        events[e_handle].is_recv() || 
+        events[e_handle].is_thread_end())
+      e_handles.push_back(e_handle);
   }
 
-  EXPECT_EQ(3, event_iters.size());
+  EXPECT_EQ(3, e_handles.size());
 
-  EventIter e_iter(event_iters[2]);
-  EXPECT_TRUE(e_iter->is_thread_end());
+  EventHandle e_handle(e_handles[2]);
+  EXPECT_TRUE(events[e_handle].is_thread_end());
 
-  EventIter e_prime_iter = event_iters[1];
-  EXPECT_TRUE(e_prime_iter->is_send());
+  EventHandle e_prime_handle = e_handles[1];
+  EXPECT_TRUE(events[e_prime_handle].is_send());
 
   // look up predecessors of a THREAD_END_EVENT
-  EXPECT_EQ(1, predecessors_map.at(e_iter).size());
-  EXPECT_EQ(e_prime_iter, predecessors_map.at(e_iter).front());
+  EXPECT_EQ(1, predecessors_map.at(e_handle).size());
+  EXPECT_EQ(e_prime_handle, predecessors_map.at(e_handle).front());
 
-  e_iter = e_prime_iter;
-  e_prime_iter = event_iters[0];
-  EXPECT_TRUE(e_prime_iter->is_recv());
+  e_handle = e_prime_handle;
+  e_prime_handle = e_handles[0];
+  EXPECT_TRUE(events[e_prime_handle].is_recv());
 
-  EXPECT_EQ(1, predecessors_map.at(e_iter).size());
-  EXPECT_EQ(e_prime_iter, predecessors_map.at(e_iter).front());
-  EXPECT_EQ(0, predecessors_map.at(e_prime_iter).size());
+  EXPECT_EQ(1, predecessors_map.at(e_handle).size());
+  EXPECT_EQ(e_prime_handle, predecessors_map.at(e_handle).front());
+  EXPECT_EQ(0, predecessors_map.at(e_prime_handle).size());
 }
 
 TEST(CrvTest, Deadlock)
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+#include "smt.h"
+#include "smt_z3.h"
+#include "smt_binary.h"
+
+using namespace smt;
+
+TEST(SmtBinaryTest, Roundtrip)
+{
+  const Int x = any<Int>("x");
+  const Bv<int> y = any<Bv<int>>("y");
+  const Bool b = any<Bool>("b!", 3);
+
+  Terms<Int> operand_terms(2);
+  operand_terms.push_back(x);
+  operand_terms.push_back(x + 1);
+
+  const Bool term0 = x + 3 < x * 2 && !b;
+  const Bool term1 = y - (-7) == 11 || distinct(std::move(operand_terms));
+  const Bool term2 = term0 && term1;
+
+  std::stringstream out;
+  BinaryWriter writer(out);
+  EXPECT_EQ(OK, writer.write_term(term0));
+  EXPECT_EQ(OK, writer.write_term(UnsafeTerm()));
+  EXPECT_EQ(OK, writer.write_term(term1));
+  const uint64_t nodes_size = writer.nodes_size();
+
+  // shared subterms are written only once
+  EXPECT_EQ(OK, writer.write_term(term2));
+  EXPECT_EQ(nodes_size + 1, writer.nodes_size());
+
+  writer.write_uint(300);
+  writer.write_int(-300);
+  writer.write_string("crv");
+
+  BinaryReader reader(out);
+  const UnsafeTerm read_term0(reader.read_term());
+  EXPECT_TRUE(reader.read_term().is_null());
+  const UnsafeTerm read_term1(reader.read_term());
+  const Bool read_term2(reader.read_term<Bool>());
+  EXPECT_EQ(writer.nodes_size(), reader.nodes_size());
+
+  EXPECT_EQ(300, reader.read_uint());
+  EXPECT_EQ(-300, reader.read_int());
+  EXPECT_EQ("crv", reader.read_string());
+
+  EXPECT_TRUE(read_term0.sort().is_bool());
+  EXPECT_TRUE(read_term1.sort().is_bool());
+
+  Z3Solver s;
+  s.unsafe_add(distinct(UnsafeTerms{term0, read_term0}));
+  EXPECT_EQ(unsat, s.check());
+
+  s.reset();
+  s.unsafe_add(distinct(UnsafeTerms{term1, read_term1}));
+  EXPECT_EQ(unsat, s.check());
+
+  s.reset();
+  s.add(term2 != read_term2);
+  EXPECT_EQ(unsat, s.check());
+
+  s.reset();
+  s.add(read_term2);
+  EXPECT_EQ(sat, s.check());
+}
+
+TEST(SmtBinaryTest, Unsupported)
+{
+  const Array<Int, Int> a = any<Array<Int, Int>>("a");
+
+  std::stringstream out;
+  BinaryWriter writer(out);
+  EXPECT_EQ(UNSUPPORT_ERROR, writer.write_term(select(a, literal<Int>(3)) == 7));
+}
+
+TEST(SmtBinaryTest, Malformed)
+{
+  std::stringstream out;
+  BinaryWriter writer(out);
+  EXPECT_EQ(OK, writer.write_term(any<Int>("x") < 3));
+
+  const std::string str(out.str());
+  std::stringstream truncated(str.substr(0, str.size() - 1));
+  BinaryReader reader(truncated);
+  EXPECT_THROW(reader.read_term(), std::runtime_error);
+
+  std::stringstream in(str);
+  BinaryReader bool_reader(in);
+  EXPECT_THROW(bool_reader.read_term<Int>(), std::runtime_error);
+}
@@ -0,0 +1,192 @@
+#include "gtest/gtest.h"
+
+#include "smt.h"
+#include "smt_z3.h"
+#include "smt_cache.h"
+
+#include <cstdio>
+
+using namespace smt;
+
+TEST(SmtCacheTest, StructuralHash)
+{
+  Z3Solver z3_solver;
+  CachingSolver s(z3_solver);
+
+  const Bool x = any<Bool>("x");
+  const Bool y = any<Bool>("y");
+  const CachingSolver::Hash empty_hash = s.hash();
+
+  s.push();
+  {
+    s.add(x && y);
+    s.add(!x);
+  }
+  const CachingSolver::Hash xy_hash = s.hash();
+  EXPECT_NE(empty_hash, xy_hash);
+  s.pop();
+  EXPECT_EQ(empty_hash, s.hash());
+
+  // structurally equal but separately allocated terms
+  s.push();
+  {
+    s.add(!any<Bool>("x"));
+    s.add(any<Bool>("x") && any<Bool>("y"));
+  }
+  EXPECT_EQ(xy_hash, s.hash());
+  s.pop();
+
+  // keyed symbols hash like their formatted symbols
+  const Bool x0 = any<Bool>("x", 0);
+  const Bool x1 = any<Bool>("x", 1);
+  s.push();
+  {
+    s.add(x0 && x1);
+  }
+  const CachingSolver::Hash keyed_hash = s.hash();
+  s.pop();
+
+  s.push();
+  {
+    s.add(any<Bool>("x0") && any<Bool>("x1"));
+  }
+  EXPECT_EQ(keyed_hash, s.hash());
+  s.pop();
+
+  s.push();
+  {
+    s.add(y && x);
+    s.add(!x);
+  }
+  EXPECT_NE(xy_hash, s.hash());
+  s.pop();
+
+  s.push();
+  {
+    s.add(any<Int>("i") < 3);
+  }
+  const CachingSolver::Hash int_hash = s.hash();
+  s.pop();
+
+  s.push();
+  {
+    s.add(any<Int>("i") < 4);
+  }
+  EXPECT_NE(int_hash, s.hash());
+  s.pop();
+
+  s.push();
+  {
+    s.add(any<Bv<int>>("i") < 3);
+  }
+  EXPECT_NE(int_hash, s.hash());
+  s.pop();
+}
+
+TEST(SmtCacheTest, Hits)
+{
+  Z3Solver z3_solver;
+  CachingSolver s(z3_solver);
+
+  const Int x = any<Int>("x");
+
+  s.push();
+  {
+    s.add(x < 3);
+    EXPECT_EQ(sat, s.check());
+    EXPECT_EQ(0, s.cache_stats().hits);
+    EXPECT_EQ(1, s.cache_stats().misses);
+
+    EXPECT_EQ(sat, s.check());
+    EXPECT_EQ(1, s.cache_stats().hits);
+    EXPECT_EQ(1, s.cache_stats().misses);
+
+    s.push();
+    {
+      s.add(x > 3);
+      EXPECT_EQ(unsat, s.check());
+      EXPECT_EQ(1, s.cache_stats().hits);
+      EXPECT_EQ(2, s.cache_stats().misses);
+    }
+    s.pop();
+  }
+  s.pop();
+
+  s.push();
+  {
+    s.add(3 < x);
+    s.add(x < 3);
+    EXPECT_EQ(unsat, s.check());
+    EXPECT_EQ(1, s.cache_stats().hits);
+    EXPECT_EQ(3, s.cache_stats().misses);
+  }
+  s.pop();
+
+  // order of assertions is irrelevant
+  s.push();
+  {
+    s.add(x < 3);
+    s.add(3 < x);
+    EXPECT_EQ(unsat, s.check());
+    EXPECT_EQ(2, s.cache_stats().hits);
+    EXPECT_EQ(3, s.cache_stats().misses);
+  }
+  s.pop();
+
+  EXPECT_EQ(0, s.cache_stats().disk_hits);
+}
+
+TEST(SmtCacheTest, Capacity)
+{
+  Z3Solver z3_solver;
+  CachingSolver s(z3_solver, 1);
+
+  const Int x = any<Int>("x");
+
+  s.push();
+  s.add(x < 3);
+  EXPECT_EQ(sat, s.check());
+  s.pop();
+
+  s.push();
+  s.add(x > 3);
+  EXPECT_EQ(sat, s.check());
+  s.pop();
+
+  // evicted
+  s.push();
+  s.add(x < 3);
+  EXPECT_EQ(sat, s.check());
+  s.pop();
+
+  EXPECT_EQ(0, s.cache_stats().hits);
+  EXPECT_EQ(3, s.cache_stats().misses);
+}
+
+TEST(SmtCacheTest, Disk)
+{
+  const std::string path("smt_cache_test.tmp");
+  std::remove(path.c_str());
+
+  const Int x = any<Int>("x");
+  {
+    Z3Solver z3_solver;
+    CachingSolver s(z3_solver, 8, path);
+    s.add(x < 3 && 3 < x);
+    EXPECT_EQ(unsat, s.check());
+    EXPECT_EQ(1, s.cache_stats().misses);
+  }
+  {
+    Z3Solver z3_solver;
+    CachingSolver s(z3_solver, 8, path);
+    s.add(x < 3 && 3 < x);
+    EXPECT_EQ(unsat, s.check());
+    EXPECT_EQ(0, s.cache_stats().misses);
+    EXPECT_EQ(1, s.cache_stats().disk_hits);
+
+    EXPECT_EQ(unsat, s.check());
+    EXPECT_EQ(1, s.cache_stats().hits);
+  }
+
+  std::remove(path.c_str());
+}
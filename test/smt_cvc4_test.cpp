@@ -737,3 +737,60 @@ TEST(SmtCVC4Test, QF_IDL)
 
   EXPECT_EQ(smt::sat, solver.check());
 }
+
+TEST(SmtCVC4Test, Clone)
+{
+  CVC4Solver solver(QF_IDL_LOGIC);
+  EXPECT_EQ(nullptr, solver.clone().get());
+  solver.set_cloneable(true);
+
+  auto x = any<Int>("x");
+  auto y = any<Int>("y");
+  solver.add(0 < y);
+
+  solver.push();
+  {
+    solver.add(x < y);
+
+    std::unique_ptr<Solver> clone(solver.clone());
+    EXPECT_NE(nullptr, clone.get());
+    EXPECT_EQ(smt::sat, clone->check());
+
+    clone->add(y < x);
+    EXPECT_EQ(smt::unsat, clone->check());
+    EXPECT_EQ(smt::sat, solver.check());
+
+    solver.add(y == 0);
+    EXPECT_EQ(smt::unsat, solver.check());
+  }
+  solver.pop();
+
+  EXPECT_EQ(smt::sat, solver.check());
+
+  std::unique_ptr<Solver> clone(solver.clone());
+  clone->add(y < 0);
+  EXPECT_EQ(smt::unsat, clone->check());
+  EXPECT_EQ(smt::sat, solver.check());
+}
+
+TEST(SmtCVC4Test, GetValue)
+{
+  CVC4Solver solver;
+
+  long long value = 0;
+  EXPECT_EQ(UNSUPPORT_ERROR, solver.get_value(any<Int>("x"), value));
+  EXPECT_EQ(OK, solver.enable_models());
+
+  auto x = any<Int>("x");
+  auto y = any<Bv<unsigned short>>("y");
+  solver.add(x + 3 == 0);
+  solver.add(y == literal<Bv<unsigned short>>(7));
+  EXPECT_EQ(smt::sat, solver.check());
+
+  EXPECT_EQ(OK, solver.get_value(x, value));
+  EXPECT_EQ(-3, value);
+  EXPECT_EQ(OK, solver.get_value(x * 2, value));
+  EXPECT_EQ(-6, value);
+  EXPECT_EQ(OK, solver.get_value(y, value));
+  EXPECT_EQ(7, value);
+}
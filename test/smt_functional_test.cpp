@@ -115,6 +115,46 @@ TEST(SmtFunctionalTest, BitVectors)
   cvc4_solver.pop();
 }
 
+// All backends agree on the values of signed and unsigned bit-vectors
+static void check_get_value(smt::Solver& solver)
+{
+  const smt::Int i = smt::any<smt::Int>("i");
+  const smt::Bv<int> x = smt::any<smt::Bv<int>>("x");
+  const smt::Bv<unsigned> y = smt::any<smt::Bv<unsigned>>("y");
+  const smt::Bv<uint64_t> z = smt::any<smt::Bv<uint64_t>>("z");
+
+  EXPECT_EQ(smt::OK, solver.enable_models());
+  solver.add(i == -7);
+  solver.add(x == smt::literal<smt::Bv<int>>(-5));
+  solver.add(y == smt::literal<smt::Bv<unsigned>>(4294967291U));
+  solver.add(z == smt::literal<smt::Bv<uint64_t>>(UINT64_MAX));
+  EXPECT_EQ(smt::sat, solver.check());
+
+  long long value = 0;
+  EXPECT_EQ(smt::OK, solver.get_value(i, value));
+  EXPECT_EQ(-7, value);
+  EXPECT_EQ(smt::OK, solver.get_value(x, value));
+  EXPECT_EQ(-5, value);
+  EXPECT_EQ(smt::OK, solver.get_value(x * smt::literal<smt::Bv<int>>(2), value));
+  EXPECT_EQ(-10, value);
+  EXPECT_EQ(smt::OK, solver.get_value(y, value));
+  EXPECT_EQ(4294967291LL, value);
+  EXPECT_EQ(smt::OK, solver.get_value(z, value));
+  EXPECT_EQ(UINT64_MAX, static_cast<uint64_t>(value));
+}
+
+TEST(SmtFunctionalTest, GetValue)
+{
+  smt::Z3Solver z3_solver;
+  check_get_value(z3_solver);
+
+  smt::MsatSolver msat_solver;
+  check_get_value(msat_solver);
+
+  smt::CVC4Solver cvc4_solver;
+  check_get_value(cvc4_solver);
+}
+
 TEST(SmtFunctionalTest, UnsafeExpr)
 {
   const smt::UnsafeDecl unsafe_decl("x", smt::bv_sort(true, sizeof(int) * 8));
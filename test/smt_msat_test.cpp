@@ -1357,3 +1357,68 @@ TEST(SmtMsatTest, QF_IDL)
 
   EXPECT_EQ(smt::sat, solver.check());
 }
+
+TEST(SmtMsatTest, Clone)
+{
+  MsatSolver solver(QF_IDL_LOGIC);
+
+  auto x = any<Int>("x");
+  auto y = any<Int>("y");
+  solver.add(0 < y);
+
+  solver.push();
+  {
+    solver.add(x < y);
+
+    std::unique_ptr<Solver> clone(solver.clone());
+    EXPECT_NE(nullptr, clone.get());
+    EXPECT_EQ(smt::sat, clone->check());
+
+    clone->add(y < x);
+    EXPECT_EQ(smt::unsat, clone->check());
+    EXPECT_EQ(smt::sat, solver.check());
+
+    solver.add(y == 0);
+    EXPECT_EQ(smt::unsat, solver.check());
+  }
+  solver.pop();
+
+  EXPECT_EQ(smt::sat, solver.check());
+
+  std::unique_ptr<Solver> clone(solver.clone());
+  clone->add(y < 0);
+  EXPECT_EQ(smt::unsat, clone->check());
+  EXPECT_EQ(smt::sat, solver.check());
+}
+
+TEST(SmtMsatTest, GetValue)
+{
+  MsatSolver solver;
+
+  long long value = 0;
+  EXPECT_EQ(UNSUPPORT_ERROR, solver.get_value(any<Int>("x"), value));
+  EXPECT_EQ(OK, solver.enable_models());
+
+  auto x = any<Int>("x");
+  auto y = any<Bv<unsigned short>>("y");
+  auto u = any<Bv<uint64_t>>("u");
+  auto s = any<Bv<int8_t>>("s");
+  solver.add(x + 3 == 0);
+  solver.add(y == literal<Bv<unsigned short>>(7));
+  solver.add(u == literal<Bv<uint64_t>>(std::numeric_limits<uint64_t>::max()));
+  solver.add(s == literal<Bv<int8_t>>(-5));
+  EXPECT_EQ(smt::sat, solver.check());
+
+  EXPECT_EQ(OK, solver.get_value(x, value));
+  EXPECT_EQ(-3, value);
+  EXPECT_EQ(OK, solver.get_value(x * 2, value));
+  EXPECT_EQ(-6, value);
+  EXPECT_EQ(OK, solver.get_value(y, value));
+  EXPECT_EQ(7, value);
+
+  // bit patterns of 64-bit unsigned values are preserved
+  EXPECT_EQ(OK, solver.get_value(u, value));
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), static_cast<uint64_t>(value));
+  EXPECT_EQ(OK, solver.get_value(s, value));
+  EXPECT_EQ(-5, value);
+}
@@ -0,0 +1,199 @@
+#include "gtest/gtest.h"
+
+#include "smt.h"
+#include "smt_z3.h"
+#include "smt_cache.h"
+#include "smt_partition.h"
+
+using namespace smt;
+
+TEST(SmtPartitionTest, Components)
+{
+  Z3Solver z3_solver;
+  PartitionSolver s(z3_solver);
+
+  const Int x = any<Int>("x");
+  const Int y = any<Int>("y");
+  const Int z = any<Int>("z");
+
+  s.add(x < 3);
+  s.add(y < 3);
+  s.add(z < 3);
+  EXPECT_EQ(sat, s.check());
+  EXPECT_EQ(1, s.partition_stats().checks);
+  EXPECT_EQ(3, s.partition_stats().components);
+
+  s.push();
+  {
+    // merges components of x and y
+    s.add(x == y);
+    EXPECT_EQ(sat, s.check());
+    EXPECT_EQ(2, s.partition_stats().checks);
+    EXPECT_EQ(5, s.partition_stats().components);
+
+    s.add(3 < z);
+    EXPECT_EQ(unsat, s.check());
+    EXPECT_EQ(3, s.partition_stats().checks);
+    EXPECT_EQ(7, s.partition_stats().components);
+  }
+  s.pop();
+
+  s.push();
+  {
+    s.add(x == y + z);
+    EXPECT_EQ(sat, s.check());
+    EXPECT_EQ(4, s.partition_stats().checks);
+    EXPECT_EQ(8, s.partition_stats().components);
+  }
+  s.pop();
+
+  s.push();
+  {
+    s.add(literal<Bool>(false));
+    EXPECT_EQ(unsat, s.check());
+  }
+  s.pop();
+
+  EXPECT_EQ(sat, s.check());
+  EXPECT_EQ(3, s.symbols_size());
+
+  // symbols of popped formulas are forgotten
+  s.push();
+  {
+    s.add(any<Int>("w") < x);
+    EXPECT_EQ(4, s.symbols_size());
+    EXPECT_EQ(sat, s.check());
+  }
+  s.pop();
+  EXPECT_EQ(3, s.symbols_size());
+}
+
+TEST(SmtPartitionTest, FuncApp)
+{
+  Z3Solver z3_solver;
+  PartitionSolver s(z3_solver);
+
+  const Decl<Func<Int, Int>> func_decl("f");
+
+  // both formulas depend on each other through f
+  s.add(apply(func_decl, 1) == 3);
+  s.add(apply(func_decl, 1) == 4);
+  EXPECT_EQ(unsat, s.check());
+  EXPECT_EQ(1, s.partition_stats().components);
+}
+
+TEST(SmtPartitionTest, CachedComponents)
+{
+  Z3Solver z3_solver;
+  CachingSolver caching_solver(z3_solver);
+  PartitionSolver s(caching_solver);
+
+  const Int x = any<Int>("x");
+  const Int y = any<Int>("y");
+
+  s.add(x < 3);
+  s.push();
+  {
+    s.add(y < 3);
+    EXPECT_EQ(sat, s.check());
+    EXPECT_EQ(2, caching_solver.cache_stats().misses);
+  }
+  s.pop();
+
+  s.push();
+  {
+    // component of x is unchanged since the previous check
+    s.add(y > 3);
+    EXPECT_EQ(sat, s.check());
+    EXPECT_EQ(1, s.partition_stats().reused_components);
+    EXPECT_EQ(0, caching_solver.cache_stats().hits);
+    EXPECT_EQ(3, caching_solver.cache_stats().misses);
+  }
+  s.pop();
+
+  s.push();
+  {
+    // component of y was popped, but it is still in the cache
+    s.add(y < 3);
+    EXPECT_EQ(sat, s.check());
+    EXPECT_EQ(2, s.partition_stats().reused_components);
+    EXPECT_EQ(1, caching_solver.cache_stats().hits);
+    EXPECT_EQ(3, caching_solver.cache_stats().misses);
+  }
+  s.pop();
+}
+
+TEST(SmtPartitionTest, ReusedComponents)
+{
+  Z3Solver z3_solver;
+  PartitionSolver s(z3_solver);
+
+  const Int x = any<Int>("x");
+  const Int y = any<Int>("y");
+  const Int z = any<Int>("z");
+
+  s.add(x < 3);
+  s.add(y < 3);
+  EXPECT_EQ(sat, s.check());
+  EXPECT_EQ(0, s.partition_stats().reused_components);
+
+  EXPECT_EQ(sat, s.check());
+  EXPECT_EQ(2, s.partition_stats().reused_components);
+
+  // merges components of x and z
+  s.add(x == z);
+  EXPECT_EQ(sat, s.check());
+  EXPECT_EQ(3, s.partition_stats().reused_components);
+
+  s.push();
+  {
+    s.add(3 < z);
+    EXPECT_EQ(unsat, s.check());
+    EXPECT_EQ(3, s.partition_stats().reused_components);
+
+    // reused unsat component ends the check
+    EXPECT_EQ(unsat, s.check());
+    EXPECT_EQ(4, s.partition_stats().reused_components);
+  }
+  s.pop();
+
+  EXPECT_EQ(sat, s.check());
+  EXPECT_EQ(5, s.partition_stats().reused_components);
+}
+
+TEST(SmtPartitionTest, Goal)
+{
+  Z3Solver z3_solver;
+  PartitionSolver s(z3_solver);
+
+  const Int x = any<Int>("x");
+  const Int y = any<Int>("y");
+  const Int z = any<Int>("z");
+
+  s.add(x < y);
+  s.add(y < 3);
+  s.add(z < 3 && 0 < z);
+
+  EXPECT_EQ(unsat, s.check_goal(x == 3));
+  EXPECT_EQ(1, s.partition_stats().sliced_terms);
+  EXPECT_EQ(6, s.partition_stats().sliced_nodes);
+
+  EXPECT_EQ(sat, s.check_goal(x == 1));
+  EXPECT_EQ(2, s.partition_stats().sliced_terms);
+  EXPECT_EQ(12, s.partition_stats().sliced_nodes);
+
+  EXPECT_EQ(unsat, s.check_goal(z == 3));
+  EXPECT_EQ(4, s.partition_stats().sliced_terms);
+  EXPECT_EQ(18, s.partition_stats().sliced_nodes);
+
+  // goal without symbols
+  EXPECT_EQ(unsat, s.check_goal(literal<Bool>(false)));
+  EXPECT_EQ(7, s.partition_stats().sliced_terms);
+
+  // goal is not asserted
+  EXPECT_EQ(sat, s.check());
+  EXPECT_EQ(5, s.partition_stats().checks);
+
+  EXPECT_EQ(unsat, s.check_goal(any<Int>("w") < x && x < 0 && 3 < y));
+  EXPECT_EQ(3, s.symbols_size());
+}
@@ -2,6 +2,8 @@
 
 #include "smt.h"
 
+#include <thread>
+
 using namespace smt;
 
 #define STATIC_EXPECT_TRUE(condition) static_assert((condition), "")
@@ -223,6 +225,55 @@ TEST(SmtTest, Decl)
   EXPECT_FALSE(d2.sort().sorts(1).is_func());
 }
 
+TEST(SmtTest, KeyedDecl)
+{
+  const Decl<Int> d0("x!", 7);
+
+  EXPECT_TRUE(d0.is_keyed());
+  EXPECT_STREQ("x!", d0.prefix());
+  EXPECT_EQ(7, d0.id());
+  EXPECT_TRUE(d0.sort().is_int());
+
+  const Decl<Int> d1("x!", 7);
+  const Decl<Int> d2("x!", 8);
+  const Decl<Int> d3("x!7");
+  const Decl<Bool> d4("x!", 7);
+
+  // keyed symbols are compared without formatting them
+  EXPECT_TRUE(d0 == d1);
+  EXPECT_FALSE(d0 == d2);
+  EXPECT_FALSE(d0.is_symbol_formatted());
+  EXPECT_FALSE(d1.is_symbol_formatted());
+  EXPECT_FALSE(d2.is_symbol_formatted());
+  EXPECT_TRUE(d3.is_symbol_formatted());
+
+  EXPECT_TRUE(d0 == d3);
+  EXPECT_FALSE(d0 == d4);
+  EXPECT_FALSE(d3.is_keyed());
+  EXPECT_TRUE(d0.is_symbol_formatted());
+
+  EXPECT_EQ("x!7", d0.symbol());
+  EXPECT_EQ("x!8", d2.symbol());
+
+  const Decl<Int> d5(d0);
+  EXPECT_TRUE(d5.is_keyed());
+  EXPECT_EQ("x!7", d5.symbol());
+
+  // formatted only once, even if symbol() is called concurrently
+  const UnsafeDecl d6("x!", 11, internal::sort<Int>());
+  EXPECT_FALSE(d6.is_symbol_formatted());
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 0; i < 4; i++) {
+    threads.emplace_back([&d6]() { EXPECT_EQ("x!11", d6.symbol()); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_TRUE(d6.is_symbol_formatted());
+}
+
 TEST(SmtTest, FuncDecl)
 {
   const Decl<Func<Bv<long>, Int>> d0("f");
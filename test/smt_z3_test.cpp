@@ -5,6 +5,8 @@
 
 #include <sstream>
 #include <cstdint>
+#include <thread>
+#include <chrono>
 
 using namespace smt;
 
@@ -964,6 +966,107 @@ TEST(SmtZ3Test, QF_IDL)
   EXPECT_EQ(smt::sat, solver.check());
 }
 
+TEST(SmtZ3Test, Clone)
+{
+  Z3Solver solver(QF_IDL_LOGIC);
+
+  auto x = any<Int>("x");
+  auto y = any<Int>("y");
+  solver.add(0 < y);
+
+  solver.push();
+  {
+    solver.add(x < y);
+
+    std::unique_ptr<Solver> clone(solver.clone());
+    EXPECT_NE(nullptr, clone.get());
+    EXPECT_EQ(smt::sat, clone->check());
+
+    clone->add(y < x);
+    EXPECT_EQ(smt::unsat, clone->check());
+    EXPECT_EQ(smt::sat, solver.check());
+
+    solver.add(y == 0);
+    EXPECT_EQ(smt::unsat, solver.check());
+  }
+  solver.pop();
+
+  EXPECT_EQ(smt::sat, solver.check());
+
+  std::unique_ptr<Solver> clone(solver.clone());
+  clone->add(y < 0);
+  EXPECT_EQ(smt::unsat, clone->check());
+  EXPECT_EQ(smt::sat, solver.check());
+}
+
+TEST(SmtZ3Test, GetValue)
+{
+  Z3Solver solver;
+  EXPECT_EQ(OK, solver.enable_models());
+
+  auto x = any<Int>("x");
+  auto y = any<Bv<unsigned short>>("y");
+  auto z = any<Bv<int>>("z");
+  solver.add(x + 3 == 0);
+  solver.add(y == literal<Bv<unsigned short>>(7));
+  solver.add(z == literal<Bv<int>>(-5));
+  EXPECT_EQ(smt::sat, solver.check());
+
+  long long value = 0;
+  EXPECT_EQ(OK, solver.get_value(x, value));
+  EXPECT_EQ(-3, value);
+  EXPECT_EQ(OK, solver.get_value(x * 2, value));
+  EXPECT_EQ(-6, value);
+  EXPECT_EQ(OK, solver.get_value(y, value));
+  EXPECT_EQ(7, value);
+  EXPECT_EQ(OK, solver.get_value(z, value));
+  EXPECT_EQ(-5, value);
+}
+
+TEST(SmtZ3Test, CheckAsync)
+{
+  Z3Solver solver;
+
+  auto x = any<Int>("x");
+  solver.add(0 < x);
+
+  Solver::CheckFuture future(solver.check_async());
+  EXPECT_EQ(smt::sat, future.get());
+  EXPECT_FALSE(solver.is_checking());
+
+  solver.add(x < 0);
+  EXPECT_EQ(smt::unsat, solver.check_async().get());
+}
+
+TEST(SmtZ3Test, CancelCheckAsync)
+{
+  Z3Solver solver;
+
+  // no positive integer solutions (Fermat's Last Theorem for n = 3)
+  auto x = any<Int>("x");
+  auto y = any<Int>("y");
+  auto z = any<Int>("z");
+  solver.add(0 < x && 0 < y && 0 < z);
+  solver.add(x * x * x + y * y * y == z * z * z);
+
+  Solver::CheckFuture future(solver.check_async());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_FALSE(future.is_ready());
+  EXPECT_TRUE(solver.is_checking());
+
+  EXPECT_THROW(solver.add(x < 0), std::logic_error);
+  EXPECT_THROW(solver.push(), std::logic_error);
+  EXPECT_THROW(solver.check(), std::logic_error);
+  EXPECT_THROW(solver.check_async(), std::logic_error);
+
+  future.cancel();
+  EXPECT_EQ(smt::unknown, future.get());
+  EXPECT_FALSE(solver.is_checking());
+
+  solver.add(x < 0);
+  EXPECT_EQ(smt::unsat, solver.check());
+}
+
 TEST(SmtZ3Test, Reset)
 {
   Z3Solver s;
@@ -0,0 +1,92 @@
+#include "crv.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// Check traces that were recorded with crv::Tracer::write()
+
+static int usage(const char* program)
+{
+  std::fprintf(stderr,
+    "usage: %s [-cvc4 | -z3 | -msat] [-bv] FILE\n", program);
+  return 2;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* backend = "-cvc4";
+  crv::TimeEncoding time_encoding = crv::INT_TIME;
+  const char* path = nullptr;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (std::strcmp(argv[i], "-cvc4") == 0 ||
+        std::strcmp(argv[i], "-z3") == 0 ||
+        std::strcmp(argv[i], "-msat") == 0)
+      backend = argv[i];
+    else if (std::strcmp(argv[i], "-bv") == 0)
+      time_encoding = crv::BV_TIME;
+    else if (path == nullptr && argv[i][0] != '-')
+      path = argv[i];
+    else
+      return usage(argv[0]);
+  }
+
+  if (path == nullptr)
+    return usage(argv[0]);
+
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+  {
+    std::fprintf(stderr, "%s: cannot open %s\n", argv[0], path);
+    return 1;
+  }
+
+  const smt::Logic logic(crv::Encoder::logic(time_encoding));
+  std::unique_ptr<smt::Solver> solver;
+  if (std::strcmp(backend, "-z3") == 0)
+    solver.reset(new smt::Z3Solver(logic));
+  else if (std::strcmp(backend, "-msat") == 0)
+    solver.reset(new smt::MsatSolver(logic));
+  else
+    solver.reset(new smt::CVC4Solver(logic));
+
+  crv::Encoder encoder(*solver, time_encoding);
+  crv::Tracer tracer;
+
+  std::printf("%-8s%12s%10s%12s\n", "trace", "events", "result", "ms");
+
+  unsigned trace = 0;
+  try
+  {
+    while (tracer.read(in))
+    {
+      const char* result = "-";
+      const auto start = std::chrono::steady_clock::now();
+      if (!tracer.errors().empty())
+      {
+        switch (encoder.check(tracer))
+        {
+        case smt::sat:   result = "sat";     break;
+        case smt::unsat: result = "unsat";   break;
+        default:         result = "unknown"; break;
+        }
+      }
+      const auto end = std::chrono::steady_clock::now();
+
+      std::printf("%-8u%12zu%10s%12lld\n", trace++,
+        tracer.events().size(), result,
+        static_cast<long long>(std::chrono::duration_cast<
+          std::chrono::milliseconds>(end - start).count()));
+    }
+  }
+  catch (const std::runtime_error& e)
+  {
+    std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+    return 1;
+  }
+
+  return 0;
+}